@@ -4,7 +4,10 @@
 #include <string>
 #include <cmath>
 #include <iostream>
+#include <sstream>
 #include "board/Board.h"
+#include "board/Piece.h"
+#include "board/GenerateCheck.h"
 
 inline std::pair<std::string, std::string> getCoord(std::string& str) {
     std::pair<std::string, std::string> pair;
@@ -50,6 +53,80 @@ inline std::string indexToAlgebraic(int idx) {
     return std::string(1, col) + std::string(1, row);
 }
 
+// Plays a coordinate move ("e2e4", "e7e8q", castling as "e1g1") for the side to move and
+// hands the turn over. False, with the board unchanged, if the move is not legal.
+inline bool playCoordinateMove(Board& b, const std::string& move) {
+    if (move.size() < 4 || move.size() > 5) return false;
+    for (int i : {0, 2}) {
+        if (move[i] < 'a' || move[i] > 'h' || move[i + 1] < '1' || move[i + 1] > '8') return false;
+    }
+
+    int from = getIndex(move.substr(0, 2));
+    int to = getIndex(move.substr(2, 2));
+    std::array<int8_t, 64>& board = b.getBoard();
+    bool white = b.getTurn();
+    if (board[from] == 0 || (board[from] > 0) != white) return false;
+
+    Board before = b;
+    Piece p{b};
+    GenerateCheck gc;
+    if (!p.move(from, to) || gc.isCheck(board, white)) {
+        b = before;
+        return false;
+    }
+
+    // Piece leaves a promoted pawn on the last rank: queen unless another piece is named
+    if (std::abs(board[to]) == 1 && (to < 8 || to >= 56)) {
+        char kind = move.size() == 5 ? move[4] : 'q';
+        int8_t piece = kind == 'r' ? 2 : kind == 'b' ? 3 : kind == 'n' ? 4 : 5;
+        board[to] = white ? piece : -piece;
+    }
 
+    // A rook captured on its corner takes its castling right with it
+    b.revokeCastling(to);
+    b.nextTurn();
+    return true;
+}
+
+// Sets up a position from "startpos [moves ...]", "fen <fen> [moves ...]" or "epd <epd>".
+// All or nothing: on failure `b` is unchanged and `error` says why ("invalid_fen",
+// "illegal_move <move>", "bad_position_command").
+inline bool setupPosition(Board& b, const std::string& spec, std::string& error) {
+    std::istringstream in(spec);
+    std::string kind, token;
+    in >> kind;
+
+    Board next;
+    if (kind == "fen") {
+        std::string fen;
+        while (in >> token && token != "moves") fen += token + " ";
+        if (!next.loadFen(fen)) {
+            error = "invalid_fen";
+            return false;
+        }
+    } else if (kind == "epd") {
+        std::string epd;
+        std::getline(in, epd);
+        if (!next.loadEpd(epd)) {
+            error = "invalid_fen";
+            return false;
+        }
+    } else if (kind == "startpos") {
+        in >> token;
+    } else {
+        error = "bad_position_command";
+        return false;
+    }
 
+    if (kind != "epd" && token == "moves") {
+        while (in >> token) {
+            if (!playCoordinateMove(next, token)) {
+                error = "illegal_move " + token;
+                return false;
+            }
+        }
+    }
 
+    b = next;
+    return true;
+}
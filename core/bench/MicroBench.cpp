@@ -0,0 +1,255 @@
+// Kernel microbenchmarks (target `microbench`): times the board, generation, evaluation
+// and move-ordering kernels over the bench suite positions and prints JSON to stdout.
+//
+//   microbench [--samples N] [--min-time-ms N] [--filter text] [--perf]
+//
+// Each kernel is run over the whole corpus in passes; a sample times as many passes as
+// fill --min-time-ms, and the JSON reports the distribution of ns per call over the
+// samples with allocations per call counted through the global operator new.
+// --perf adds hardware counters per call from one more sample (null where the system
+// doesn't allow counting them).
+
+#include "../board/Board.h"
+#include "../board/Generate.h"
+#include "../board/GenerateCheck.h"
+#include "../engine/Evaluation.h"
+#include "../engine/Search.h"
+#include "../engine/TranspositionTable.h"
+#include "../engine/Bench.h"
+#include "../engine/PerfCounters.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// ----------------------------------------------------------
+// Allocation counting
+// ----------------------------------------------------------
+static long long allocations = 0;
+static long long allocatedBytes = 0;
+
+static void* countedAlloc(std::size_t size) {
+    allocations++;
+    allocatedBytes += (long long)size;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+// Array forms replaced too, so every new/delete pair goes through malloc/free
+void* operator new(std::size_t size) { return countedAlloc(size); }
+void* operator new[](std::size_t size) { return countedAlloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+// Results are folded in here so the compiler can't drop the measured calls
+static volatile long long sink = 0;
+
+// Corpus position with its own board state (castling, en passant) for Generate
+struct Position {
+    Board b;
+    Generate g{b};
+    std::array<int8_t, 64> board;
+    bool white = true;
+    std::vector<Gen> moves; // pseudo-legal moves
+};
+
+struct Kernel {
+    std::string name;
+    long long callsPerPass;
+    std::function<void()> pass;
+};
+
+struct Stats {
+    double median, mean, stddev, min, max, ci95;
+};
+
+static Stats summarize(std::vector<double> v) {
+    std::sort(v.begin(), v.end());
+    Stats s{};
+    size_t n = v.size();
+    s.median = n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+    s.min = v.front();
+    s.max = v.back();
+    for (double x : v) s.mean += x;
+    s.mean /= n;
+    for (double x : v) s.stddev += (x - s.mean) * (x - s.mean);
+    s.stddev = n > 1 ? std::sqrt(s.stddev / (n - 1)) : 0;
+    s.ci95 = 1.96 * s.stddev / std::sqrt((double)n);
+    return s;
+}
+
+static std::string number(double x) {
+    std::ostringstream out;
+    out.precision(4);
+    out << std::fixed << x;
+    return out.str();
+}
+
+class MicroBench {
+
+    std::vector<std::unique_ptr<Position>> corpus;
+
+    // Move ordering needs a Search; it doesn't look at the search's own board
+    Board scratch;
+    Generate scratchGen{scratch};
+    TranspositionTable tt{1};
+    std::unique_ptr<Search> search = std::make_unique<Search>(scratch, scratchGen, tt);
+
+    GenerateCheck check;
+    Evaluation eval;
+    std::vector<Gen> buffer;
+
+public:
+
+    MicroBench() {
+        buffer.reserve(256);
+        for (int i = 0; i < Bench::suiteSize(); i++) {
+            auto p = std::make_unique<Position>();
+            if (!p->b.loadFen(Bench::position(i))) continue;
+            p->board = p->b.getBoard();
+            p->white = p->b.getTurn();
+            p->moves = p->g.generate(p->board, p->white);
+            corpus.push_back(std::move(p));
+        }
+    }
+
+    int positions() const { return (int)corpus.size(); }
+
+    std::vector<Kernel> kernels() {
+        long long moves = 0;
+        for (auto& p : corpus) moves += (long long)p->moves.size();
+        long long count = (long long)corpus.size();
+
+        return {
+            {"Generate::generate", count, [this] {
+                for (auto& p : corpus) {
+                    p->g.generate(p->board, p->white, buffer);
+                    sink = sink + (long long)buffer.size();
+                }
+            }},
+            {"Generate::makeMove", moves, [this] {
+                for (auto& p : corpus) {
+                    for (Gen& move : p->moves) sink = sink + p->g.makeMove(p->board, p->white, move).has_value();
+                }
+            }},
+            {"GenerateCheck::isCheck", count, [this] {
+                for (auto& p : corpus) sink = sink + check.isCheck(p->board, p->white);
+            }},
+            {"Evaluation::evaluation", count, [this] {
+                for (auto& p : corpus) sink = sink + eval.evaluation(p->board);
+            }},
+            {"Evaluation::isAttacked", count * 64, [this] {
+                for (auto& p : corpus) {
+                    for (int sq = 0; sq < 64; sq++) sink = sink + eval.isAttacked(p->board, sq, !p->white);
+                }
+            }},
+            {"Search::orderMoves", count, [this] {
+                for (auto& p : corpus) {
+                    buffer.assign(p->moves.begin(), p->moves.end());
+                    search->orderMoves(buffer, p->board, 0, p->white);
+                    sink = sink + (buffer.empty() ? 0 : buffer[0].to);
+                }
+            }},
+        };
+    }
+};
+
+int main(int argc, char* argv[]) {
+    int samples = 20;
+    double minTimeMs = 20;
+    std::string filter;
+    bool perf = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--perf") perf = true;
+        else if (i + 1 >= argc) break;
+        else if (arg == "--samples") samples = std::max(std::atoi(argv[++i]), 2);
+        else if (arg == "--min-time-ms") minTimeMs = std::max(std::atof(argv[++i]), 1.0);
+        else if (arg == "--filter") filter = argv[++i];
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto elapsedNs = [](Clock::time_point since) {
+        return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - since).count();
+    };
+
+    MicroBench bench;
+    std::unique_ptr<PerfCounters> counters;
+    if (perf) counters = std::make_unique<PerfCounters>();
+
+    std::string json = "{\"benchmark\": \"microbench\", \"compiler\": \"" + std::string(__VERSION__)
+        + "\", \"positions\": " + std::to_string(bench.positions())
+        + ", \"samples\": " + std::to_string(samples);
+    if (counters) json += std::string(", \"perf_available\": ") + (counters->available() ? "true" : "false");
+    json += ", \"kernels\": [";
+    bool first = true;
+
+    for (Kernel& k : bench.kernels()) {
+        if (!filter.empty() && k.name.find(filter) == std::string::npos) continue;
+        std::cerr << k.name << "...\n";
+
+        // Warm up, then find how many passes fill a sample
+        long long passes = 1;
+        for (;;) {
+            auto started = Clock::now();
+            for (long long i = 0; i < passes; i++) k.pass();
+            if (elapsedNs(started) >= minTimeMs * 1e6) break;
+            passes *= 2;
+        }
+
+        std::vector<double> nsPerCall;
+        for (int s = 0; s < samples; s++) {
+            auto started = Clock::now();
+            for (long long i = 0; i < passes; i++) k.pass();
+            nsPerCall.push_back(elapsedNs(started) / (double)(passes * k.callsPerPass));
+        }
+
+        long long allocsBefore = allocations, bytesBefore = allocatedBytes;
+        k.pass();
+        double allocsPerCall = (double)(allocations - allocsBefore) / k.callsPerPass;
+        double bytesPerCall = (double)(allocatedBytes - bytesBefore) / k.callsPerPass;
+
+        Stats st = summarize(nsPerCall);
+        double callsPerPosition = (double)k.callsPerPass / bench.positions();
+
+        if (!first) json += ", ";
+        first = false;
+        json += "{\"name\": \"" + k.name + "\""
+            + ", \"calls_per_position\": " + number(callsPerPosition)
+            + ", \"passes_per_sample\": " + std::to_string(passes)
+            + ", \"ns_per_call\": {\"median\": " + number(st.median) + ", \"mean\": " + number(st.mean)
+            + ", \"stddev\": " + number(st.stddev) + ", \"ci95\": " + number(st.ci95)
+            + ", \"min\": " + number(st.min) + ", \"max\": " + number(st.max) + "}"
+            + ", \"calls_per_sec\": " + number(1e9 / st.median)
+            + ", \"positions_per_sec\": " + number(1e9 / (st.median * callsPerPosition))
+            + ", \"allocs_per_call\": " + number(allocsPerCall)
+            + ", \"bytes_per_call\": " + number(bytesPerCall);
+
+        if (counters) {
+            counters->start();
+            for (long long i = 0; i < passes; i++) k.pass();
+            PerfReading r = counters->stop();
+
+            json += ", \"perf_per_call\": {";
+            for (int e = 0; e < PerfReading::EVENTS; e++) {
+                json += std::string(e > 0 ? ", " : "") + "\"" + PerfCounters::name(e) + "\": "
+                    + (r.valid[e] ? number((double)r.value[e] / (passes * k.callsPerPass)) : "null");
+            }
+            json += "}";
+        }
+        json += "}";
+    }
+
+    json += "]}";
+    std::cout << json << "\n";
+    return 0;
+}
@@ -1 +1,172 @@
+#include "Board.h"
+#include "Zobrist.h"
+#include <algorithm>
+#include <cctype>
+#include <sstream>
 
+// ----------------------------------------------------------
+// Position history
+// ----------------------------------------------------------
+void Board::recordPosition() {
+    keyHistory.push_back(hashBoard(board, white) ^ hashCastling(*this));
+}
+
+bool Board::isThreefoldRepetition() const {
+    if (keyHistory.empty()) return false;
+
+    uint64_t current = keyHistory.back();
+    int count = 1;
+    int last = (int)keyHistory.size() - 1;
+
+    // Only positions since the last irreversible move, same side to move
+    for (int i = 2; i <= halfmoveClock && last - i >= 0; i += 2) {
+        if (keyHistory[last - i] == current && ++count >= 3) return true;
+    }
+    return false;
+}
+
+// ----------------------------------------------------------
+// FEN setup
+// ----------------------------------------------------------
+bool Board::loadFen(const std::string& fen) {
+    std::istringstream in(fen);
+    std::string placement, side, castling = "-", enPassant = "-";
+    int halfmoves = 0, fullmoves = 1;
+    if (!(in >> placement >> side)) return false;
+    in >> castling >> enPassant >> halfmoves >> fullmoves;
+
+    std::array<int8_t, 64> squares{};
+    int rank = 7, file = 0;
+    for (char ch : placement) {
+        if (ch == '/') {
+            if (file != 8 || rank == 0) return false;
+            rank--;
+            file = 0;
+        } else if (ch >= '1' && ch <= '8') {
+            file += ch - '0';
+            if (file > 8) return false;
+        } else {
+            int8_t piece;
+            switch (std::tolower(ch)) {
+                case 'p': piece = 1; break;
+                case 'r': piece = 2; break;
+                case 'b': piece = 3; break;
+                case 'n': piece = 4; break;
+                case 'q': piece = 5; break;
+                case 'k': piece = 6; break;
+                default: return false;
+            }
+            if (file > 7) return false;
+            squares[rank * 8 + file++] = std::isupper(ch) ? piece : -piece;
+        }
+    }
+    if (rank != 0 || file != 8 || (side != "w" && side != "b")) return false;
+
+    int kings[2] = {-1, -1};
+    for (int sq = 0; sq < 64; sq++) {
+        if (squares[sq] == 6) kings[0] = sq;
+        if (squares[sq] == -6) kings[1] = sq;
+    }
+    if (kings[0] < 0 || kings[1] < 0) return false;
+
+    board = squares;
+    white = side == "w";
+    whiteKing = kings[0];
+    blackKing = kings[1];
+    whiteKingSide = castling.find('K') != std::string::npos;
+    whiteQueenSide = castling.find('Q') != std::string::npos;
+    blackKingSide = castling.find('k') != std::string::npos;
+    blackQueenSide = castling.find('q') != std::string::npos;
+    halfmoveClock = std::max(halfmoves, 0);
+    fullmoveNumber = std::max(fullmoves, 1);
+
+    // En passant is recognised from the last move: rebuild the double step behind the target
+    lastMove = {-1, -1, 0, std::nullopt};
+    if (enPassant.size() == 2 && enPassant[0] >= 'a' && enPassant[0] <= 'h' && (enPassant[1] == '3' || enPassant[1] == '6')) {
+        int target = (enPassant[1] - '1') * 8 + (enPassant[0] - 'a');
+        int step = white ? -8 : 8; // towards the pawn that just moved
+        lastMove = {target + step, target - step, white ? -1 : 1, std::nullopt};
+    }
+
+    keyHistory.clear();
+    recordPosition();
+    return true;
+}
+
+bool Board::loadEpd(const std::string& epd, std::map<std::string, std::string>* operations) {
+    std::istringstream in(epd);
+    std::string fields[4];
+    for (auto& field : fields) {
+        if (!(in >> field)) return false;
+    }
+
+    // Operations: "bm e4; id \"test 1\"; hmvc 0;"
+    std::map<std::string, std::string> ops;
+    std::string rest;
+    std::getline(in, rest);
+    std::istringstream list(rest);
+    std::string operation;
+    while (std::getline(list, operation, ';')) {
+        std::istringstream op(operation);
+        std::string opcode, operand;
+        if (!(op >> opcode)) continue;
+        std::getline(op >> std::ws, operand);
+        ops[opcode] = operand;
+    }
+
+    std::string halfmoves = ops.count("hmvc") ? ops["hmvc"] : "0";
+    std::string fullmoves = ops.count("fmvn") ? ops["fmvn"] : "1";
+    if (!loadFen(fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3] + " " + halfmoves + " " + fullmoves)) {
+        return false;
+    }
+
+    if (operations) *operations = std::move(ops);
+    return true;
+}
+
+// ----------------------------------------------------------
+// FEN export
+// ----------------------------------------------------------
+std::string Board::toEpd() const {
+    std::string fen;
+    for (int rank = 7; rank >= 0; rank--) {
+        int empty = 0;
+        for (int file = 0; file < 8; file++) {
+            int8_t p = board[rank * 8 + file];
+            if (p == 0) {
+                empty++;
+                continue;
+            }
+            if (empty > 0) fen += char('0' + empty);
+            empty = 0;
+            char c = " prbnqk"[std::abs(p)];
+            fen += p > 0 ? (char)std::toupper(c) : c;
+        }
+        if (empty > 0) fen += char('0' + empty);
+        if (rank > 0) fen += '/';
+    }
+
+    fen += white ? " w " : " b ";
+
+    std::string castling;
+    if (whiteKingSide) castling += 'K';
+    if (whiteQueenSide) castling += 'Q';
+    if (blackKingSide) castling += 'k';
+    if (blackQueenSide) castling += 'q';
+    fen += castling.empty() ? "-" : castling;
+
+    // En passant target behind a pawn that just moved two squares
+    if (std::abs(lastMove.piece) == 1 && std::abs(lastMove.to - lastMove.from) == 16) {
+        int target = (lastMove.to + lastMove.from) / 2;
+        fen += " ";
+        fen += char('a' + target % 8);
+        fen += char('1' + target / 8);
+    } else {
+        fen += " -";
+    }
+    return fen;
+}
+
+std::string Board::toFen() const {
+    return toEpd() + " " + std::to_string(halfmoveClock) + " " + std::to_string(fullmoveNumber);
+}
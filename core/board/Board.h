@@ -7,6 +7,10 @@
 #include <cstdint>
 #include <iomanip>
 #include <optional>
+#include <vector>
+#include <string>
+#include <map>
+#include <cstdlib>
 
 //0 is empty square
 //White Pawn - 1, Black Pawn - -1
@@ -40,6 +44,18 @@ class Board {
     bool blackKingSide = true;
     bool blackQueenSide = true;
 
+    // Game history: key of every position reached, the current one last
+    std::vector<uint64_t> keyHistory;
+
+    // Plies since the last capture or pawn move (fifty-move rule)
+    int halfmoveClock = 0;
+
+    // Starts at 1, incremented after each black move
+    int fullmoveNumber = 1;
+
+    // Appends the key of the current position to keyHistory
+    void recordPosition();
+
 public:
 
      
@@ -72,10 +88,18 @@ board = {
 
         white = true;
 
+        recordPosition();
     }
 
+    // Called once a move has been played on the board: hands the turn over and
+    // records the new position for repetition / fifty-move detection
     void nextTurn() {
         white = !white;
+
+        bool irreversible = std::abs(lastMove.piece) == 1 || lastMove.pieceTaken.value_or(0) != 0;
+        halfmoveClock = irreversible ? 0 : halfmoveClock + 1;
+        if (white) fullmoveNumber++;
+        recordPosition();
     }
 
     void setTurn(bool& turn) {
@@ -115,6 +139,29 @@ board = {
         return lastMove;
     }
 
+    // Sets up the position of a FEN string (placement, side, castling, en passant, clocks;
+    // missing clocks default to 0 and 1) and restarts the game history there.
+    // False, board unchanged, if malformed.
+    bool loadFen(const std::string& fen);
+
+    // EPD: the first four FEN fields, then "opcode operand;" operations. The hmvc and fmvn
+    // operations set the clocks; all operations are returned in `operations` if given.
+    bool loadEpd(const std::string& epd, std::map<std::string, std::string>* operations = nullptr);
+
+    // Current position as FEN, or as the four EPD fields
+    std::string toFen() const;
+    std::string toEpd() const;
+
+    const std::vector<uint64_t>& getKeyHistory() const { return keyHistory; }
+    int getHalfmoveClock() const { return halfmoveClock; }
+    int getFullmoveNumber() const { return fullmoveNumber; }
+
+    // Current position occurred at least twice before (threefold repetition)
+    bool isThreefoldRepetition() const;
+
+    // 100 plies without a capture or pawn move
+    bool isFiftyMoveDraw() const { return halfmoveClock >= 100; }
+
     // Castling rights accessors
     bool canCastleKingSide(bool isWhite) const { return isWhite ? whiteKingSide : blackKingSide; }
     bool canCastleQueenSide(bool isWhite) const { return isWhite ? whiteQueenSide : blackQueenSide; }
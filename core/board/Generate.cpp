@@ -8,6 +8,7 @@
 #include "../Utils.h"
 #include "../board/Check.h"
 #include "../board/GenerateCheck.h"
+#include "../engine/Trace.h"
 
 // Check opponent using the PASSED board array, not the Board reference.
 // This is critical for search — the board array is the hypothetical position.
@@ -23,11 +24,22 @@ the generate() will loop through the board and return the current players turn m
 
 
 std::vector<Gen> Generate::generate(std::array<int8_t, 64> board, bool white) {
+    TraceSample sample("Generate::generate");
     clearGen(); 
-    return white ? generateWhite(board) : generateBlack(board); 
+    white ? generateWhite(board) : generateBlack(board);
+    return moves;
+}
+
+void Generate::generate(std::array<int8_t, 64> board, bool white, std::vector<Gen>& out) {
+    TraceSample sample("Generate::generate");
+    // Borrow the caller's buffer as the generation target, then hand it back
+    moves.swap(out);
+    clearGen();
+    white ? generateWhite(board) : generateBlack(board);
+    moves.swap(out);
 }
 
-std::vector<Gen> Generate::generateWhite(std::array<int8_t, 64> board) {
+void Generate::generateWhite(std::array<int8_t, 64> board) {
     
     int pieceCounter = 0;
 
@@ -42,16 +54,14 @@ std::vector<Gen> Generate::generateWhite(std::array<int8_t, 64> board) {
 
             //no more pieces to scan for
             if(pieceCounter == totalPieces) {
-                return moves;
+                return;
             }
 
         }
     }
-
-    return moves;
 }
 
-std::vector<Gen> Generate::generateBlack(std::array<int8_t, 64> board) {
+void Generate::generateBlack(std::array<int8_t, 64> board) {
     
     int pieceCounter = 0;
 
@@ -65,13 +75,154 @@ std::vector<Gen> Generate::generateBlack(std::array<int8_t, 64> board) {
             }
 
             if(pieceCounter == totalPieces) {
-                return moves;
+                return;
             }
 
         }
     }
-    
-    return moves;
+}
+
+// ----------------------------------------------------------
+// Tactical generation: no quiet moves are generated only to be skipped
+// ----------------------------------------------------------
+void Generate::generateTactical(const std::array<int8_t, 64>& board, bool white, std::vector<Gen>& out, bool includeChecks) {
+    moves.swap(out);
+    clearGen();
+
+    if (includeChecks) {
+        // Quiet checks need the full move list; keep tactical moves and quiet moves that check
+        white ? generateWhite(board) : generateBlack(board);
+
+        size_t kept = 0;
+        for (size_t i = 0; i < moves.size(); i++) {
+            Gen& m = moves[i];
+            bool keep = m.pieceTaken != 0 || m.promotion;
+            if (!keep) {
+                std::optional<std::array<int8_t, 64>> next = makeMove(board, white, m);
+                keep = next.has_value() && genCheck.isCheck(next.value(), !white);
+            }
+            if (keep) moves[kept++] = m;
+        }
+        moves.resize(kept);
+    } else {
+        for (int idx = 0; idx < 64; idx++) {
+            if ((white && board[idx] > 0) || (!white && board[idx] < 0)) {
+                generateTacticalFrom(board, idx);
+            }
+        }
+    }
+
+    moves.swap(out);
+}
+
+void Generate::addCapture(const std::array<int8_t, 64>& board, int from, int to, bool promotion) {
+    Gen capture;
+    capture.from = from;
+    capture.to = to;
+    capture.piece = board[from];
+    capture.pieceTaken = board[to];
+    capture.promotion = promotion;
+    moves.push_back(capture);
+}
+
+void Generate::generateTacticalFrom(const std::array<int8_t, 64>& board, int idx) {
+
+    PieceType pieceType = static_cast<PieceType>(abs(board[idx]));
+    int row = idx / 8;
+    int col = idx % 8;
+
+    switch(pieceType) {
+
+        case PieceType::PAWN: {
+            bool white = board[idx] > 0;
+            int r = row + (white ? 1 : -1);
+            if (r < 0 || r >= 8) break;
+
+            bool isPromotion = (white && r == 7) || (!white && r == 0);
+
+            for (int dc : {-1, 1}) {
+                int c = col + dc;
+                if (c >= 0 && c < 8 && isOpp(board, idx, r * 8 + c)) {
+                    addCapture(board, idx, r * 8 + c, isPromotion);
+                }
+            }
+
+            // Quiet promotion push
+            if (isPromotion && board[r * 8 + col] == 0) {
+                Gen promo;
+                promo.from = idx;
+                promo.to = r * 8 + col;
+                promo.piece = board[idx];
+                promo.pieceTaken = 0;
+                promo.promotion = true;
+                moves.push_back(promo);
+            }
+
+            // En passant, same rule as generatePawnMoves
+            LastMove& lm = b.getLastMove();
+            if (lm.to >= 0 && ((white && row == 4 && lm.to / 8 == 4) || (!white && row == 3 && lm.to / 8 == 3)) &&
+                abs(lm.to % 8 - col) == 1 &&
+                static_cast<PieceType>(abs(board[lm.to])) == PieceType::PAWN &&
+                isOpp(board, idx, lm.to)) {
+
+                Gen enp;
+                enp.from = idx;
+                enp.to = white ? lm.to + 8 : lm.to - 8;
+                enp.piece = board[idx];
+                enp.pieceTaken = board[lm.to];
+                moves.push_back(enp);
+            }
+            break;
+        }
+
+        case PieceType::KNIGHT:
+            for (auto dir : b.knight) {
+                int r = row + dir[0];
+                int c = col + dir[1];
+                if (r >= 0 && r < 8 && c >= 0 && c < 8 && isOpp(board, idx, r * 8 + c)) {
+                    addCapture(board, idx, r * 8 + c, false);
+                }
+            }
+            break;
+
+        case PieceType::KING:
+            for (int dr : {-1, 0, 1}) {
+                for (int dc : {-1, 0, 1}) {
+                    int r = row + dr;
+                    int c = col + dc;
+                    if ((dr != 0 || dc != 0) && r >= 0 && r < 8 && c >= 0 && c < 8 && isOpp(board, idx, r * 8 + c)) {
+                        addCapture(board, idx, r * 8 + c, false);
+                    }
+                }
+            }
+            break;
+
+        case PieceType::BISHOP:
+        case PieceType::ROOK:
+        case PieceType::QUEEN: {
+            static const int dirs[8][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+            int first = pieceType == PieceType::BISHOP ? 4 : 0;
+            int last = pieceType == PieceType::ROOK ? 4 : 8;
+
+            // Only the first piece on each ray matters
+            for (int k = first; k < last; k++) {
+                int r = row + dirs[k][0];
+                int c = col + dirs[k][1];
+                while (r >= 0 && r < 8 && c >= 0 && c < 8) {
+                    int curr = r * 8 + c;
+                    if (board[curr] != 0) {
+                        if (isOpp(board, idx, curr)) addCapture(board, idx, curr, false);
+                        break;
+                    }
+                    r += dirs[k][0];
+                    c += dirs[k][1];
+                }
+            }
+            break;
+        }
+
+        default: break;
+    }
 }
 
 void Generate::directGen(std::array<int8_t, 64> board, int idx) {
@@ -19,8 +19,12 @@ class Generate {
     GenerateCheck genCheck;
     std::vector<Gen> moves;
    
-    std::vector<Gen> generateWhite(std::array<int8_t, 64> board);
-    std::vector<Gen> generateBlack(std::array<int8_t, 64> board);
+    void generateWhite(std::array<int8_t, 64> board);
+    void generateBlack(std::array<int8_t, 64> board);
+
+    // Tactical moves of one piece: captures, en passant and promotions
+    void generateTacticalFrom(const std::array<int8_t, 64>& board, int pos);
+    void addCapture(const std::array<int8_t, 64>& board, int from, int to, bool promotion);
 
     int bishop[4][2] = {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
 
@@ -35,8 +39,15 @@ public:
     }
 
     std::vector<Gen> generate(std::array<int8_t, 64> board, bool white);
+
+    // Same, but fills `out` in place so a caller-owned buffer is reused without allocating
+    void generate(std::array<int8_t, 64> board, bool white, std::vector<Gen>& out);
     void directGen(std::array<int8_t, 64> board, int piece);
 
+    // Captures (including en passant) and queen promotions only, for quiescence search.
+    // With includeChecks, quiet moves that give check are added as well.
+    void generateTactical(const std::array<int8_t, 64>& board, bool white, std::vector<Gen>& out, bool includeChecks = false);
+
     void generateRookMoves(std::array<int8_t, 64> board, int pos);
     void generateBishopMoves(std::array<int8_t, 64> board, int pos);
     void generateKnightMoves(std::array<int8_t, 64> board, int pos);
@@ -5,7 +5,8 @@ bool GenerateCheck::isCheck(const std::array<int8_t, 64>& board, bool turn) {
     return scanRookQueen(board, kingPos) ||
            scanDiagonal(board, kingPos) ||
            scanKnight(board, kingPos) ||
-           scanPawn(board, kingPos);
+           scanPawn(board, kingPos) ||
+           scanKing(board, kingPos);
 }
 
 bool GenerateCheck::scanRookQueen(const std::array<int8_t, 64>& board, int kingPos) {
@@ -100,6 +101,24 @@ bool GenerateCheck::scanPawn(const std::array<int8_t, 64>& board, int kingPos) {
     return false;
 }
 
+// kings can't stand next to each other
+bool GenerateCheck::scanKing(const std::array<int8_t, 64>& board, int kingPos) {
+    int row = kingPos / 8;
+    int col = kingPos % 8;
+
+    for(int dr = -1; dr <= 1; dr++) {
+        for(int dc = -1; dc <= 1; dc++) {
+            int r = row + dr;
+            int c = col + dc;
+            if((dr != 0 || dc != 0) && r >= 0 && r < 8 && c >= 0 && c < 8) {
+                int idx = r*8 + c;
+                if(board[idx] == -board[kingPos]) return true;
+            }
+        }
+    }
+    return false;
+}
+
 int GenerateCheck::wKingPos(const std::array<int8_t, 64>& board) {
     for (int i = 0; i < 64; i++) {
         if (board[i] == static_cast<int8_t>(PieceType::KING)) return i;
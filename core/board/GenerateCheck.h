@@ -18,6 +18,7 @@ private:
     bool scanDiagonal(const std::array<int8_t, 64>& board, int kingPos);
     bool scanKnight(const std::array<int8_t, 64>& board, int kingPos);
     bool scanPawn(const std::array<int8_t, 64>& board, int kingPos);
+    bool scanKing(const std::array<int8_t, 64>& board, int kingPos);
 
     bool isOpponent(const std::array<int8_t, 64>& board, int kingPos, int targetPos);
 
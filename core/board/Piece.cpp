@@ -23,6 +23,35 @@
 //  0  1  2  3  4  5  6  7
 
 
+bool Piece::move(int from, int to) {
+
+    PieceType piece = getPieceType(abs(board.at(from)));
+
+    switch(piece) {
+
+        case PieceType::PAWN:
+            return pawnMove(from, to);
+
+        case PieceType::ROOK:
+            return rookMove(from, to);
+
+        case PieceType::KNIGHT:
+            return knightMove(from, to);
+
+        case PieceType::BISHOP:
+            return bishopMove(from, to);
+
+        case PieceType::QUEEN:
+            return queenMove(from, to);
+
+        case PieceType::KING:
+            return kingMove(from, to);
+
+        default: return emptyMove(from, to);
+
+    };
+}
+
 //en passant and double moves
 bool Piece::pawnMove(int from, int to) {
 
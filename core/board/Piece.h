@@ -36,6 +36,9 @@ public:
         return piece == 0;
     }
 
+    // Dispatches to the move rule of the piece on `from` and applies it if legal
+    bool move(int from, int to);
+
     bool pawnMove(int from, int to);
     bool knightMove(int from, int to);
     bool bishopMove(int from, int to);
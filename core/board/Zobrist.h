@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "Board.h"
+
+// Zobrist keys for position hashing.
+// Generated from a fixed seed so hashes are identical across runs and processes.
+struct ZobristKeys {
+    uint64_t piece[13][64]; // indexed by piece + 6 (-6..6), 0 slot (empty) unused
+    uint64_t side;
+    uint64_t castling[4];   // white K, white Q, black K, black Q
+    uint64_t enPassant[8];  // file of the en passant target
+
+    ZobristKeys() {
+        uint64_t seed = 0x9E3779B97F4A7C15ULL;
+
+        // splitmix64
+        auto next = [&seed]() {
+            uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        };
+
+        for (int p = 0; p < 13; p++)
+            for (int sq = 0; sq < 64; sq++)
+                piece[p][sq] = (p == 6) ? 0 : next();
+
+        side = next();
+        for (auto& k : castling) k = next();
+        for (auto& k : enPassant) k = next();
+    }
+};
+
+inline const ZobristKeys& zobristKeys() {
+    static const ZobristKeys keys;
+    return keys;
+}
+
+// Hash of piece placement and side to move
+inline uint64_t hashBoard(const std::array<int8_t, 64>& board, bool white) {
+    const ZobristKeys& z = zobristKeys();
+    uint64_t key = 0;
+
+    for (int sq = 0; sq < 64; sq++) {
+        if (board[sq] != 0) key ^= z.piece[board[sq] + 6][sq];
+    }
+
+    if (!white) key ^= z.side;
+    return key;
+}
+
+// Castling rights of the game board (constant for the duration of a search)
+inline uint64_t hashCastling(const Board& b) {
+    const ZobristKeys& z = zobristKeys();
+    uint64_t key = 0;
+
+    if (b.canCastleKingSide(true))   key ^= z.castling[0];
+    if (b.canCastleQueenSide(true))  key ^= z.castling[1];
+    if (b.canCastleKingSide(false))  key ^= z.castling[2];
+    if (b.canCastleQueenSide(false)) key ^= z.castling[3];
+
+    return key;
+}
@@ -0,0 +1,251 @@
+#include "chessengine.h"
+#include "../Utils.h"
+#include "../board/Board.h"
+#include "../board/Generate.h"
+#include "../engine/Evaluation.h"
+#include "../engine/Search.h"
+#include "../engine/Tablebase.h"
+#include "../engine/TranspositionTable.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+static const int MAX_DEPTH = 64;
+
+struct ce_engine {
+    Board b;
+    Generate g{b};
+    TranspositionTable tt;
+    Tablebase tablebase;
+    Search s{b, g, tt};
+
+    std::thread worker;
+    mutable std::mutex mutex;
+    std::condition_variable finished;
+    bool searching = false;
+    bool destroyed = false; // ce_destroy from a callback: the worker frees the engine
+
+
+    explicit ce_engine(size_t hashMB) : tt(hashMB) {}
+};
+
+static std::string moveToCoordinate(const Gen& move) {
+    return indexToAlgebraic(move.from) + indexToAlgebraic(move.to) + (move.promotion ? "q" : "");
+}
+
+static int copyOut(const std::string& text, char* buffer, size_t size) {
+    if (!buffer || size == 0) return CE_ERR_INVALID_ARGUMENT;
+    if (text.size() + 1 > size) return CE_ERR_BUFFER_TOO_SMALL;
+    std::memcpy(buffer, text.c_str(), text.size() + 1);
+    return CE_OK;
+}
+
+static bool isSearching(const ce_engine* engine) {
+    std::lock_guard<std::mutex> lock(engine->mutex);
+    return engine->searching;
+}
+
+// Callbacks run on the worker: waiting for or joining it from there would never return
+static bool onWorker(const ce_engine* engine) {
+    return engine->worker.get_id() == std::this_thread::get_id();
+}
+
+static std::vector<Gen> legalMoves(ce_engine* engine) {
+    std::array<int8_t, 64>& board = engine->b.getBoard();
+    bool white = engine->b.getTurn();
+
+    std::vector<Gen> legal;
+    for (Gen& move : engine->g.generate(board, white)) {
+        if (engine->g.makeMove(board, white, move).has_value()) legal.push_back(move);
+    }
+    return legal;
+}
+
+// ----------------------------------------------------------
+// Lifetime and position
+// ----------------------------------------------------------
+int ce_version(void) {
+    return CE_API_VERSION;
+}
+
+ce_engine* ce_create(int hash_mb, const char* tablebase_dir) {
+    try {
+        ce_engine* engine = new ce_engine(hash_mb > 0 ? (size_t)hash_mb : 16);
+        if (tablebase_dir && engine->tablebase.open(tablebase_dir) > 0) {
+            engine->s.setTablebase(&engine->tablebase);
+        }
+        return engine;
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void ce_destroy(ce_engine* engine) {
+    if (!engine) return;
+    if (onWorker(engine)) {
+        engine->s.stop();
+        engine->destroyed = true;
+        return;
+    }
+    ce_search_stop(engine);
+    if (engine->worker.joinable()) engine->worker.join();
+    delete engine;
+}
+
+int ce_new_game(ce_engine* engine) {
+    if (!engine) return CE_ERR_INVALID_ARGUMENT;
+    if (isSearching(engine)) return CE_ERR_BUSY;
+
+    engine->tt.clear();
+    engine->s.clearHistory();
+    engine->b = Board();
+    return CE_OK;
+}
+
+int ce_set_position(ce_engine* engine, const char* spec) {
+    if (!engine || !spec) return CE_ERR_INVALID_ARGUMENT;
+    if (isSearching(engine)) return CE_ERR_BUSY;
+
+    std::string error;
+    if (setupPosition(engine->b, spec, error)) return CE_OK;
+    return error.rfind("illegal_move", 0) == 0 ? CE_ERR_ILLEGAL_MOVE : CE_ERR_INVALID_POSITION;
+}
+
+int ce_make_move(ce_engine* engine, const char* move) {
+    if (!engine || !move) return CE_ERR_INVALID_ARGUMENT;
+    if (isSearching(engine)) return CE_ERR_BUSY;
+
+    return playCoordinateMove(engine->b, move) ? CE_OK : CE_ERR_ILLEGAL_MOVE;
+}
+
+int ce_get_fen(const ce_engine* engine, char* buffer, size_t size) {
+    if (!engine) return CE_ERR_INVALID_ARGUMENT;
+    return copyOut(engine->b.toFen(), buffer, size);
+}
+
+// ----------------------------------------------------------
+// Queries
+// ----------------------------------------------------------
+int ce_legal_moves(ce_engine* engine, char* buffer, size_t size) {
+    if (!engine) return CE_ERR_INVALID_ARGUMENT;
+    if (isSearching(engine)) return CE_ERR_BUSY;
+
+    std::vector<Gen> legal = legalMoves(engine);
+    std::string text;
+    for (const Gen& move : legal) {
+        if (!text.empty()) text += ' ';
+        text += moveToCoordinate(move);
+    }
+
+    int result = copyOut(text, buffer, size);
+    return result == CE_OK ? (int)legal.size() : result;
+}
+
+int ce_evaluate(ce_engine* engine, int* score_cp) {
+    if (!engine || !score_cp) return CE_ERR_INVALID_ARGUMENT;
+
+    Evaluation eval;
+    *score_cp = eval.evaluation(engine->b.getBoard());
+    return CE_OK;
+}
+
+// ----------------------------------------------------------
+// Searching
+// ----------------------------------------------------------
+int ce_search_start(ce_engine* engine, const ce_limits* limits,
+                    ce_info_callback on_info, ce_bestmove_callback on_bestmove, void* user) {
+    if (!engine) return CE_ERR_INVALID_ARGUMENT;
+    {
+        std::lock_guard<std::mutex> lock(engine->mutex);
+        if (engine->searching) return CE_ERR_BUSY;
+        engine->searching = true;
+    }
+    if (engine->worker.joinable()) engine->worker.join();
+
+    ce_limits l = limits ? *limits : ce_limits{};
+    Search& s = engine->s;
+    s.clearStop();
+    s.setNodeLimit(std::max<int64_t>(l.nodes, 0));
+    auto started = std::chrono::steady_clock::now();
+    if (l.movetime_ms > 0) s.setDeadline(started + std::chrono::milliseconds(l.movetime_ms));
+    else s.clearDeadline();
+
+    engine->worker = std::thread([engine, l, on_info, on_bestmove, user, started] {
+        Search& s = engine->s;
+        std::array<int8_t, 64> root = engine->b.getBoard();
+        bool white = engine->b.getTurn();
+        int depth = l.depth > 0 ? std::min(l.depth, MAX_DEPTH) : MAX_DEPTH;
+
+        std::vector<Gen> best;
+        s.setIterationCallback([&](int d, int score, const std::vector<Gen>& pv) {
+            best = pv;
+            if (!on_info) return true;
+
+            std::string line;
+            for (const Gen& move : pv) line += (line.empty() ? "" : " ") + moveToCoordinate(move);
+
+            long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count();
+            int mate = Search::mateDistance(score);
+
+            ce_info info;
+            info.depth = d;
+            info.seldepth = std::max(s.getSelDepth(), d);
+            info.score_cp = white ? score : -score;
+            info.mate = white ? mate : -mate;
+            info.nodes = s.getNodesSearched();
+            info.nps = info.nodes * 1000 / std::max(ms, 1LL);
+            info.hashfull = engine->tt.hashfull();
+            info.time_ms = ms;
+            info.pv = line.c_str();
+            on_info(&info, user);
+            return true;
+        });
+
+        std::vector<Gen> pv;
+        s.searchPV(root, depth, white, -2000000, 2000000, pv);
+        s.setIterationCallback(nullptr);
+
+        // Tablebase roots are answered without iterating; stopped early: any legal move
+        if (best.empty()) best = pv;
+        if (best.empty()) {
+            std::vector<Gen> legal = legalMoves(engine);
+            if (!legal.empty()) best.push_back(legal[0]);
+        }
+
+        if (on_bestmove && !engine->destroyed) {
+            std::string move = best.empty() ? "" : moveToCoordinate(best[0]);
+            std::string ponder = best.size() > 1 ? moveToCoordinate(best[1]) : "";
+            on_bestmove(move.c_str(), ponder.c_str(), user);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(engine->mutex);
+            engine->searching = false;
+            engine->finished.notify_all();
+        }
+        if (engine->destroyed) {
+            engine->worker.detach();
+            delete engine;
+        }
+    });
+    return CE_OK;
+}
+
+void ce_search_stop(ce_engine* engine) {
+    if (!engine) return;
+    engine->s.stop();
+    if (!onWorker(engine)) ce_search_wait(engine);
+}
+
+void ce_search_wait(ce_engine* engine) {
+    if (!engine || onWorker(engine)) return;
+    std::unique_lock<std::mutex> lock(engine->mutex);
+    engine->finished.wait(lock, [&] { return !engine->searching; });
+}
+
+int ce_is_searching(const ce_engine* engine) {
+    return engine && isSearching(engine) ? 1 : 0;
+}
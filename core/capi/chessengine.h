@@ -0,0 +1,109 @@
+#pragma once
+
+/*
+ * C API of the chess engine (libchessengine), for embedding the engine in-process.
+ *
+ * Moves are coordinate strings as in UCI ("e2e4", "e7e8q", castling "e1g1").
+ * Scores are centipawns from White's point of view.
+ *
+ * An engine instance is not thread-safe, except that ce_search_stop() may be
+ * called from any thread. Searches run on a thread owned by the instance; the
+ * callbacks are invoked on that thread.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  define CE_API __declspec(dllexport)
+#else
+#  define CE_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CE_API_VERSION 1
+
+/* Return codes */
+#define CE_OK                    0
+#define CE_ERR_INVALID_ARGUMENT -1
+#define CE_ERR_INVALID_POSITION -2
+#define CE_ERR_ILLEGAL_MOVE     -3
+#define CE_ERR_BUSY             -4  /* a search is running */
+#define CE_ERR_BUFFER_TOO_SMALL -5
+
+typedef struct ce_engine ce_engine;
+
+/* Search limits; 0 means no limit. Without any limit the search runs until stopped. */
+typedef struct ce_limits {
+    int depth;
+    int64_t nodes;
+    int movetime_ms;
+} ce_limits;
+
+/* Progress after each completed depth */
+typedef struct ce_info {
+    int depth;
+    int seldepth;
+    int score_cp;
+    int mate;           /* moves to mate, negative when Black mates; 0 if none */
+    int64_t nodes;
+    int64_t nps;
+    int hashfull;       /* permille */
+    int64_t time_ms;
+    const char* pv;     /* space-separated moves, valid during the callback only */
+} ce_info;
+
+typedef void (*ce_info_callback)(const ce_info* info, void* user);
+
+/* End of a search: best move and expected reply ("" if none) */
+typedef void (*ce_bestmove_callback)(const char* bestmove, const char* ponder, void* user);
+
+CE_API int ce_version(void);
+
+/* Engine with its own hash table (hash_mb <= 0: 16 MB). Tablebases are loaded from
+ * tablebase_dir when not NULL. Returns NULL on allocation failure. */
+CE_API ce_engine* ce_create(int hash_mb, const char* tablebase_dir);
+
+/* Stops any search and frees the engine. From a callback, the engine is freed once the
+ * search thread has finished, and no further callbacks run. */
+CE_API void ce_destroy(ce_engine* engine);
+
+/* Clears the hash table and search histories */
+CE_API int ce_new_game(ce_engine* engine);
+
+/* "startpos [moves ...]", "fen <fen> [moves ...]" or "epd <epd>".
+ * The position is left unchanged on failure. */
+CE_API int ce_set_position(ce_engine* engine, const char* spec);
+
+/* Plays one move on the current position */
+CE_API int ce_make_move(ce_engine* engine, const char* move);
+
+/* FEN of the current position, NUL-terminated */
+CE_API int ce_get_fen(const ce_engine* engine, char* buffer, size_t size);
+
+/* Legal moves of the side to move, space-separated. Returns the move count, or an error. */
+CE_API int ce_legal_moves(ce_engine* engine, char* buffer, size_t size);
+
+/* Static evaluation of the current position */
+CE_API int ce_evaluate(ce_engine* engine, int* score_cp);
+
+/* Starts searching the current position in the background. Either callback may be NULL. */
+CE_API int ce_search_start(ce_engine* engine, const ce_limits* limits,
+                           ce_info_callback on_info, ce_bestmove_callback on_bestmove, void* user);
+
+/* Stops the running search; the bestmove callback has run when this returns, except
+ * when called from a callback, which returns at once (the search ends after it) */
+CE_API void ce_search_stop(ce_engine* engine);
+
+/* Waits for the running search to finish on its own limits (returns at once from a callback) */
+CE_API void ce_search_wait(ce_engine* engine);
+
+/* Non-zero while a search is running */
+CE_API int ce_is_searching(const ce_engine* engine);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,207 @@
+#include "AnalysisCache.h"
+#include "../board/Zobrist.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const uint64_t CACHE_MAGIC = 0x4348455353414332ULL; // "CHESSAC2" (keys with en passant)
+static const size_t HEADER_BYTES = 64;
+
+struct AnalysisCache::Header {
+    uint64_t magic;
+    uint64_t recordSize;
+    uint64_t bucketCount;
+    std::atomic<uint32_t> stamp; // use counter, shared by every process
+};
+
+// ----------------------------------------------------------
+// Opening: validate an existing file or lay out a fresh one
+// ----------------------------------------------------------
+bool AnalysisCache::open(const std::string& path, size_t megabytes) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return false;
+
+    // Another process may be creating the same file
+    flock(fd, LOCK_EX);
+
+    struct stat st{};
+    fstat(fd, &st);
+    size_t bytes = (size_t)st.st_size;
+
+    bool valid = false;
+    void* base = MAP_FAILED;
+    if (bytes > HEADER_BYTES) {
+        base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base != MAP_FAILED) {
+            const Header* h = static_cast<const Header*>(base);
+            size_t buckets = h->bucketCount;
+            valid = h->magic == CACHE_MAGIC && h->recordSize == sizeof(Record)
+                && buckets > 0 && (buckets & (buckets - 1)) == 0
+                && HEADER_BYTES + buckets * BUCKET * sizeof(Record) <= bytes;
+            if (!valid) munmap(base, bytes);
+        }
+    }
+
+    if (!valid) {
+        // Largest power of two number of buckets within the size
+        size_t buckets = 1;
+        while (buckets * 2 * BUCKET * sizeof(Record) <= std::max<size_t>(megabytes, 1) * 1024 * 1024) buckets *= 2;
+        bytes = HEADER_BYTES + buckets * BUCKET * sizeof(Record);
+
+        base = MAP_FAILED;
+        if (ftruncate(fd, 0) == 0 && ftruncate(fd, (off_t)bytes) == 0) {
+            base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        if (base != MAP_FAILED) {
+            Header* h = static_cast<Header*>(base);
+            h->magic = CACHE_MAGIC;
+            h->recordSize = sizeof(Record);
+            h->bucketCount = buckets;
+            h->stamp.store(0);
+        }
+    }
+
+    flock(fd, LOCK_UN);
+    ::close(fd);
+    if (base == MAP_FAILED) return false;
+
+    header = static_cast<Header*>(base);
+    records = reinterpret_cast<Record*>(static_cast<char*>(base) + HEADER_BYTES);
+    bucketCount = header->bucketCount;
+    mappedBytes = bytes;
+    return true;
+}
+
+bool AnalysisCache::openFromEnvironment() {
+    const char* path = std::getenv("CHESS_ANALYSIS_CACHE");
+    if (!path || !*path) return false;
+
+    const char* mb = std::getenv("CHESS_ANALYSIS_CACHE_MB");
+    return open(path, mb ? std::strtoul(mb, nullptr, 10) : 64);
+}
+
+void AnalysisCache::close() {
+    if (header) munmap(header, mappedBytes);
+    header = nullptr;
+    records = nullptr;
+    bucketCount = 0;
+    mappedBytes = 0;
+}
+
+// ----------------------------------------------------------
+// Records
+// ----------------------------------------------------------
+uint64_t AnalysisCache::checksum(const Record& r) {
+    // FNV-1a over everything from the key on; never 0, which marks an empty record
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(&r.key);
+    const unsigned char* end = reinterpret_cast<const unsigned char*>(&r) + sizeof(Record);
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (; p < end; p++) h = (h ^ *p) * 0x100000001B3ULL;
+    return h ? h : 1;
+}
+
+// File of the en passant target when the side to move has a pawn beside the pawn that
+// just moved two squares, -1 otherwise
+static int enPassantFile(Board& b) {
+    const LastMove& lm = b.getLastMove();
+    const std::array<int8_t, 64>& board = b.getBoard();
+    if (lm.to < 0 || std::abs(lm.piece) != 1 || std::abs(lm.to - lm.from) != 16) return -1;
+
+    int8_t capturer = lm.piece > 0 ? -1 : 1;
+    int file = lm.to % 8;
+    if ((file > 0 && board[lm.to - 1] == capturer) || (file < 7 && board[lm.to + 1] == capturer)) return file;
+    return -1;
+}
+
+uint64_t AnalysisCache::key(Board& b) {
+    uint64_t k = hashBoard(b.getBoard(), b.getTurn()) ^ hashCastling(b);
+    int file = enPassantFile(b);
+    if (file >= 0) k ^= zobristKeys().enPassant[file];
+    return k;
+}
+
+uint32_t AnalysisCache::nextStamp() {
+    return header->stamp.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+bool AnalysisCache::lookup(Board& b, int depth, CachedAnalysis& out) {
+    if (!records) return false;
+
+    uint64_t k = key(b);
+    std::lock_guard<std::mutex> lock(mutex);
+    Record* bucket = &records[(k & (bucketCount - 1)) * BUCKET];
+
+    for (int i = 0; i < BUCKET; i++) {
+        Record r;
+        std::memcpy(&r, &bucket[i], sizeof(Record));
+        if (r.check == 0 || r.key != k || checksum(r) != r.check) continue;
+        if (r.depth < depth) return false;
+
+        out.depth = r.depth;
+        out.eval = r.eval;
+        out.lines.clear();
+        for (int l = 0; l < std::min<int>(r.lineCount, LINES); l++) {
+            ScoredMove line;
+            line.score = r.scores[l];
+            for (int m = 0; m < std::min<int>(r.lengths[l], LINE_MOVES); m++) {
+                Gen move;
+                move.from = r.moves[l][m] & 63;
+                move.to = (r.moves[l][m] >> 6) & 63;
+                move.promotion = (r.moves[l][m] >> 12) & 1;
+                line.line.push_back(move);
+            }
+            out.lines.push_back(line);
+        }
+
+        bucket[i].stamp = nextStamp();
+        return true;
+    }
+    return false;
+}
+
+void AnalysisCache::store(Board& b, const CachedAnalysis& analysis) {
+    if (!records) return;
+
+    Record r{};
+    r.key = key(b);
+    r.eval = analysis.eval;
+    r.depth = (uint8_t)std::clamp(analysis.depth, 0, 255);
+    r.lineCount = (uint8_t)std::min<size_t>(analysis.lines.size(), LINES);
+    for (int l = 0; l < r.lineCount; l++) {
+        const ScoredMove& line = analysis.lines[l];
+        r.scores[l] = line.score;
+        r.lengths[l] = (uint8_t)std::min<size_t>(line.line.size(), LINE_MOVES);
+        for (int m = 0; m < r.lengths[l]; m++) {
+            const Gen& move = line.line[m];
+            r.moves[l][m] = (uint16_t)(move.from | move.to << 6 | (move.promotion ? 1 << 12 : 0));
+        }
+    }
+    r.check = checksum(r);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Record* bucket = &records[(r.key & (bucketCount - 1)) * BUCKET];
+
+    // Same position: keep the deeper analysis. Otherwise an empty or the least recently used record.
+    Record* victim = &bucket[0];
+    for (int i = 0; i < BUCKET; i++) {
+        Record& slot = bucket[i];
+        if (slot.check != 0 && slot.key == r.key && checksum(slot) == slot.check) {
+            if (slot.depth > r.depth) return;
+            victim = &slot;
+            break;
+        }
+        if (victim->check == 0) continue;
+        if (slot.check == 0 || slot.stamp < victim->stamp) victim = &slot;
+    }
+
+    r.stamp = nextStamp();
+    std::memcpy(victim, &r, sizeof(Record));
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../board/Board.h"
+#include "../board/Generate.h"
+#include "Search.h"
+
+// Finished analysis of one position as answered to a client (scores white-relative)
+struct CachedAnalysis {
+    int depth = 0;
+    int eval = 0;
+    std::vector<ScoredMove> lines; // moves carry from, to and promotion only
+};
+
+// Persistent store of finished analyses, memory-mapped from a file so it survives
+// restarts and can be shared by several processes on the host.
+//
+// The file is a fixed number of 4-record buckets indexed by the position key
+// (placement, side to move, castling rights, and the en passant file when a capture
+// there is possible). The key deliberately leaves out the repetition history and the
+// halfmove clock: a cached line can miss a draw by repetition or the fifty-move rule. A position keeps one record; a new result
+// replaces it only if searched at least as deep. A full bucket evicts its least
+// recently used record. Each record carries a checksum so a torn write from another
+// process reads as a miss; inside a process a mutex serializes access.
+class AnalysisCache {
+
+    static const int LINES = 3;
+    static const int LINE_MOVES = 12;
+    static const int BUCKET = 4;
+
+    // 128 bytes on disk
+    struct Record {
+        uint32_t stamp;     // last use; not covered by the checksum
+        uint32_t reserved0;
+        uint64_t check;     // hash of the bytes from `key` on; 0 = empty
+        uint64_t key;
+        int32_t eval;
+        uint8_t depth;
+        uint8_t lineCount;
+        uint8_t lengths[LINES];
+        uint8_t reserved1[3];
+        int32_t scores[LINES];
+        uint16_t moves[LINES][LINE_MOVES]; // from | to << 6 | promotion << 12
+        uint8_t reserved2[8];
+    };
+    static_assert(sizeof(Record) == 128, "cache record layout");
+
+    struct Header;
+
+    Header* header = nullptr;
+    Record* records = nullptr;
+    size_t bucketCount = 0;
+    size_t mappedBytes = 0;
+    std::mutex mutex;
+
+    static uint64_t checksum(const Record& r);
+    static uint64_t key(Board& b);
+    uint32_t nextStamp();
+
+public:
+
+    AnalysisCache() = default;
+    ~AnalysisCache() { close(); }
+
+    AnalysisCache(const AnalysisCache&) = delete;
+    AnalysisCache& operator=(const AnalysisCache&) = delete;
+
+    // Maps the cache file, creating it with about `megabytes` if missing or unusable;
+    // an existing cache keeps its size
+    bool open(const std::string& path, size_t megabytes);
+
+    // open() on $CHESS_ANALYSIS_CACHE, sized by $CHESS_ANALYSIS_CACHE_MB (default 64),
+    // when the variable is set
+    bool openFromEnvironment();
+
+    void close();
+    bool isOpen() const { return records != nullptr; }
+
+    // Analysis of this position searched to at least `depth`
+    bool lookup(Board& b, int depth, CachedAnalysis& out);
+
+    // Records an analysis unless a deeper one is already stored
+    void store(Board& b, const CachedAnalysis& analysis);
+};
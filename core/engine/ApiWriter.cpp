@@ -0,0 +1,401 @@
+#include "ApiWriter.h"
+#include "../Utils.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+
+// ----------------------------------------------------------
+// Framing and output
+// ----------------------------------------------------------
+void ApiWriter::begin(uint8_t type) {
+    buf.clear();
+    if (binary) {
+        buf.append(4, '\0'); // length, patched in end()
+        put8(type);
+    }
+}
+
+void ApiWriter::end() {
+    if (binary) {
+        uint32_t length = (uint32_t)(buf.size() - 4);
+        for (int i = 0; i < 4; i++) buf[i] = (char)(length >> (8 * i));
+    } else {
+        if (!session.empty()) {
+            std::string body;
+            body.swap(buf);
+            buf = "{\"session\": ";
+            jsonString(session);
+            buf += ", ";
+            buf.append(body, 1, std::string::npos);
+        }
+        buf.push_back('\n');
+    }
+
+    // Anything still sitting in the iostream buffer must go out first
+    if (fd == STDOUT_FILENO) std::cout.flush();
+
+    std::unique_lock<std::mutex> guard;
+    if (lock) guard = std::unique_lock<std::mutex>(*lock);
+
+    size_t done = 0;
+    while (done < buf.size()) {
+        ssize_t n = ::write(fd, buf.data() + done, buf.size() - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        done += (size_t)n;
+    }
+}
+
+void ApiWriter::put16(uint16_t v) {
+    put8((uint8_t)v);
+    put8((uint8_t)(v >> 8));
+}
+
+void ApiWriter::put32(uint32_t v) {
+    put16((uint16_t)v);
+    put16((uint16_t)(v >> 16));
+}
+
+void ApiWriter::put64(uint64_t v) {
+    put32((uint32_t)v);
+    put32((uint32_t)(v >> 32));
+}
+
+void ApiWriter::putString(const std::string& s) {
+    size_t length = std::min<size_t>(s.size(), 0xFFFF); // longer strings are cut
+    put16((uint16_t)length);
+    buf.append(s, 0, length);
+}
+
+void ApiWriter::putLine(const std::vector<Gen>& line) {
+    size_t count = std::min<size_t>(line.size(), 255);
+    put8((uint8_t)count);
+    for (size_t i = 0; i < count; i++) put16(packMove(line[i]));
+}
+
+void ApiWriter::jsonString(const std::string& s) {
+    buf += '"';
+    for (unsigned char c : s) {
+        switch (c) {
+            case '"':  buf += "\\\""; break;
+            case '\\': buf += "\\\\"; break;
+            case '\n': buf += "\\n"; break;
+            case '\r': buf += "\\r"; break;
+            case '\t': buf += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    buf += escaped;
+                } else {
+                    buf += (char)c;
+                }
+        }
+    }
+    buf += '"';
+}
+
+void ApiWriter::jsonLine(const std::vector<Gen>& line) {
+    buf += "[";
+    for (size_t i = 0; i < line.size(); i++) {
+        if (i > 0) buf += ", ";
+        buf += "\"" + indexToAlgebraic(line[i].from) + indexToAlgebraic(line[i].to) + "\"";
+    }
+    buf += "]";
+}
+
+static const char* turnName(bool whiteToMove) {
+    return whiteToMove ? "\"white\"" : "\"black\"";
+}
+
+// ----------------------------------------------------------
+// Messages
+// ----------------------------------------------------------
+void ApiWriter::ready() {
+    begin(READY);
+    if (!binary) buf += "{\"ready\": true}";
+    end();
+}
+
+void ApiWriter::newGame() {
+    begin(NEW_GAME);
+    if (!binary) buf += "{\"status\": \"new_game_started\"}";
+    end();
+}
+
+void ApiWriter::moveOk(bool whiteToMove) {
+    begin(MOVE_OK);
+    if (binary) put8(whiteToMove ? 0 : 1);
+    else buf += std::string("{\"status\": \"move_ok\", \"turn\": ") + turnName(whiteToMove) + "}";
+    end();
+}
+
+void ApiWriter::illegalMove() {
+    begin(ILLEGAL_MOVE);
+    if (!binary) buf += "{\"status\": \"illegal_move\"}";
+    end();
+}
+
+void ApiWriter::positionOk(const std::string& fen, bool whiteToMove) {
+    begin(POSITION_OK);
+    if (binary) {
+        put8(whiteToMove ? 0 : 1);
+        putString(fen);
+    } else {
+        buf += "{\"status\": \"position_ok\", \"fen\": ";
+        jsonString(fen);
+        buf += std::string(", \"turn\": ") + turnName(whiteToMove) + "}";
+    }
+    end();
+}
+
+void ApiWriter::fen(const std::string& fen) {
+    begin(FEN);
+    if (binary) {
+        putString(fen);
+    } else {
+        buf += "{\"fen\": ";
+        jsonString(fen);
+        buf += "}";
+    }
+    end();
+}
+
+void ApiWriter::error(const std::string& message) {
+    begin(ERROR);
+    if (binary) {
+        putString(message);
+    } else {
+        buf += "{\"status\": \"error\", \"message\": ";
+        jsonString(message); // may quote client input
+        buf += "}";
+    }
+    end();
+}
+
+void ApiWriter::pondering(const Gen& move) {
+    begin(PONDERING);
+    if (binary) put16(packMove(move));
+    else buf += "{\"status\": \"pondering\", \"move\": \"" + indexToAlgebraic(move.from) + indexToAlgebraic(move.to) + "\"}";
+    end();
+}
+
+void ApiWriter::info(const SearchInfo& info) {
+    begin(INFO);
+    if (binary) {
+        put8((uint8_t)std::min(info.depth, 255));
+        put8((uint8_t)std::min(info.selDepth, 255));
+        put32((uint32_t)info.score);
+        put16((uint16_t)info.mate);
+        put64((uint64_t)info.nodes);
+        put64((uint64_t)info.nps);
+        put16((uint16_t)info.hashfull);
+        put32((uint32_t)info.timeMs);
+        putLine(info.pv);
+    } else {
+        buf += "{\"type\": \"info\", \"depth\": " + std::to_string(info.depth)
+            + ", \"seldepth\": " + std::to_string(info.selDepth)
+            + ", \"score\": " + std::to_string(info.score)
+            + ", \"mate\": " + (info.mate != 0 ? std::to_string(info.mate) : "null")
+            + ", \"nodes\": " + std::to_string(info.nodes)
+            + ", \"nps\": " + std::to_string(info.nps)
+            + ", \"hashfull\": " + std::to_string(info.hashfull)
+            + ", \"time\": " + std::to_string(info.timeMs)
+            + ", \"pv\": ";
+        jsonLine(info.pv);
+        buf += "}";
+    }
+    end();
+}
+
+void ApiWriter::bestmove(int eval, bool ponderhit, bool book, bool cached, const std::vector<ScoredMove>& lines) {
+    bool hasMove = !lines.empty() && !lines[0].line.empty();
+
+    begin(BESTMOVE);
+    if (binary) {
+        put32((uint32_t)eval);
+        put8((ponderhit ? 1 : 0) | (book ? 2 : 0) | (cached ? 4 : 0));
+        put16(hasMove ? packMove(lines[0].line[0]) : 0);
+        size_t count = std::min<size_t>(lines.size(), 255);
+        put8((uint8_t)count);
+        for (size_t i = 0; i < count; i++) {
+            put32((uint32_t)lines[i].score);
+            putLine(lines[i].line);
+        }
+    } else {
+        buf += "{\"type\": \"bestmove\", \"eval\": " + std::to_string(eval)
+            + ", \"ponderhit\": " + (ponderhit ? "true" : "false")
+            + ", \"book\": " + (book ? "true" : "false")
+            + ", \"cached\": " + (cached ? "true" : "false") + ", ";
+
+        // bestmove (first move of best line)
+        if (hasMove) {
+            const Gen& move = lines[0].line[0];
+            buf += "\"bestmove\": \"" + indexToAlgebraic(move.from) + indexToAlgebraic(move.to) + "\", ";
+        } else {
+            buf += "\"bestmove\": null, ";
+        }
+
+        buf += "\"topMoves\": [";
+        for (size_t i = 0; i < lines.size(); i++) {
+            if (i > 0) buf += ", ";
+            buf += "{\"score\": " + std::to_string(lines[i].score) + ", \"line\": ";
+            jsonLine(lines[i].line);
+            buf += "}";
+        }
+        buf += "]}";
+    }
+    end();
+}
+
+void ApiWriter::closed() {
+    begin(CLOSED);
+    if (!binary) buf += "{\"status\": \"closed\"}";
+    end();
+}
+
+void ApiWriter::rootMove(int score, long long nodes, const std::string& worker, const std::vector<Gen>& line) {
+    begin(ROOT_MOVE);
+    if (binary) {
+        put32((uint32_t)score);
+        put64((uint64_t)nodes);
+        putString(worker);
+        putLine(line);
+    } else {
+        buf += "{\"type\": \"rootmove\", \"move\": ";
+        if (line.empty()) buf += "null";
+        else buf += "\"" + indexToAlgebraic(line[0].from) + indexToAlgebraic(line[0].to) + "\"";
+        buf += ", \"score\": " + std::to_string(score) + ", \"nodes\": " + std::to_string(nodes)
+            + ", \"worker\": ";
+        jsonString(worker);
+        buf += ", \"line\": ";
+        jsonLine(line);
+        buf += "}";
+    }
+    end();
+}
+
+void ApiWriter::bench(const BenchResult& result) {
+    begin(BENCH);
+    if (binary) {
+        put8((uint8_t)result.depth);
+        put8((uint8_t)result.threads);
+        put16((uint16_t)result.positions);
+        put64((uint64_t)result.nodes);
+        put32((uint32_t)result.timeMs);
+        put64((uint64_t)result.nps);
+    } else {
+        buf += "{\"type\": \"bench\", \"depth\": " + std::to_string(result.depth)
+            + ", \"threads\": " + std::to_string(result.threads)
+            + ", \"positions\": " + std::to_string(result.positions)
+            + ", \"nodes\": " + std::to_string(result.nodes)
+            + ", \"time\": " + std::to_string(result.timeMs)
+            + ", \"nps\": " + std::to_string(result.nps) + "}";
+    }
+    end();
+}
+
+void ApiWriter::stats(const SearchStats& stats) {
+    const long long counters[] = {
+        stats.nodes, stats.qsearchNodes, stats.betaCutoffs, stats.firstMoveCutoffs,
+        stats.nullMoveTries, stats.nullMovePrunes, stats.rfpPrunes, stats.lmrReductions,
+        stats.lmrResearches, stats.checkExtensions, stats.ttProbes, stats.ttHits,
+        stats.ttCutoffs, stats.evaluations,
+    };
+    size_t iterations = std::min<size_t>(stats.iterationMs.size(), 255);
+
+    begin(STATS);
+    if (binary) {
+        put8(stats.detailed ? 1 : 0);
+        put8((uint8_t)stats.selDepth);
+        for (long long c : counters) put64((uint64_t)c);
+        put8((uint8_t)iterations);
+        for (size_t i = 0; i < iterations; i++) put32((uint32_t)stats.iterationMs[i]);
+    } else {
+        static const char* const names[] = {
+            "nodes", "qsearchNodes", "betaCutoffs", "firstMoveCutoffs",
+            "nullMoveTries", "nullMovePrunes", "rfpPrunes", "lmrReductions",
+            "lmrResearches", "checkExtensions", "ttProbes", "ttHits",
+            "ttCutoffs", "evaluations",
+        };
+        char rate[32];
+        buf += "{\"type\": \"stats\", \"detailed\": ";
+        buf += stats.detailed ? "true" : "false";
+        buf += ", \"seldepth\": " + std::to_string(stats.selDepth);
+        for (size_t i = 0; i < sizeof(counters) / sizeof(counters[0]); i++) {
+            buf += ", \"" + std::string(names[i]) + "\": " + std::to_string(counters[i]);
+        }
+        snprintf(rate, sizeof(rate), "%.4f", stats.firstMoveCutoffRate());
+        buf += ", \"firstMoveCutoffRate\": " + std::string(rate);
+        snprintf(rate, sizeof(rate), "%.4f", stats.ttHitRate());
+        buf += ", \"ttHitRate\": " + std::string(rate);
+        buf += ", \"iterationTimes\": [";
+        for (size_t i = 0; i < stats.iterationMs.size(); i++) {
+            if (i > 0) buf += ", ";
+            buf += std::to_string(stats.iterationMs[i]);
+        }
+        buf += "]}";
+    }
+    end();
+}
+
+void ApiWriter::latency(const LatencyStats& latency) {
+    std::vector<std::pair<std::string, const Histogram*>> commands, depths;
+    for (int c = 0; c < LatencyStats::COMMANDS; c++) {
+        const Histogram& h = latency.command((LatencyStats::Command)c);
+        if (h.count() > 0) commands.push_back({LatencyStats::name((LatencyStats::Command)c), &h});
+    }
+    for (int d = 1; d <= LatencyStats::MAX_DEPTH; d++) {
+        if (latency.depth(d).count() > 0) depths.push_back({std::to_string(d), &latency.depth(d)});
+    }
+
+    begin(LATENCY);
+    if (binary) {
+        auto putHistogram = [&](const std::string& name, const Histogram& h) {
+            putString(name);
+            put64(h.count());
+            put64(h.mean());
+            put64(h.percentile(50));
+            put64(h.percentile(95));
+            put64(h.percentile(99));
+            put64(h.max());
+        };
+        put32((uint32_t)latency.uptimeSeconds());
+        put8((uint8_t)(commands.size() + depths.size() + 1));
+        for (auto& [name, h] : commands) putHistogram(name, *h);
+        for (auto& [name, h] : depths) putHistogram("depth " + name, *h);
+        putHistogram("nps", latency.nps());
+    } else {
+        auto jsonHistogram = [&](const Histogram& h) {
+            buf += "{\"count\": " + std::to_string(h.count())
+                + ", \"mean\": " + std::to_string(h.mean())
+                + ", \"p50\": " + std::to_string(h.percentile(50))
+                + ", \"p95\": " + std::to_string(h.percentile(95))
+                + ", \"p99\": " + std::to_string(h.percentile(99))
+                + ", \"max\": " + std::to_string(h.max()) + "}";
+        };
+        auto jsonGroup = [&](const std::vector<std::pair<std::string, const Histogram*>>& group) {
+            buf += "{";
+            for (size_t i = 0; i < group.size(); i++) {
+                if (i > 0) buf += ", ";
+                buf += "\"" + group[i].first + "\": ";
+                jsonHistogram(*group[i].second);
+            }
+            buf += "}";
+        };
+
+        // Latencies in microseconds
+        buf += "{\"type\": \"latency\", \"uptime\": " + std::to_string(latency.uptimeSeconds())
+            + ", \"commands\": ";
+        jsonGroup(commands);
+        buf += ", \"searchDepths\": ";
+        jsonGroup(depths);
+        buf += ", \"nps\": ";
+        jsonHistogram(latency.nps());
+        buf += "}";
+    }
+    end();
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "../board/Generate.h"
+#include "Search.h"
+#include "Bench.h"
+#include "LatencyStats.h"
+
+// Progress of one completed search depth (scores white-relative)
+struct SearchInfo {
+    int depth = 0;
+    int selDepth = 0;
+    int score = 0;
+    int mate = 0;           // moves to mate, negative when black mates; 0 = none
+    long long nodes = 0;
+    long long nps = 0;
+    int hashfull = 0;       // permille
+    long long timeMs = 0;
+    std::vector<Gen> pv;
+};
+
+// Replies of the --api protocol, either as JSON lines (default) or as
+// length-prefixed binary frames (--api --binary).
+//
+// Each message is assembled in a reused buffer and handed to the kernel with a
+// single write(), without going through iostream buffering. Writers that share a
+// descriptor (daemon sessions on one connection) pass a common lock; a session tag
+// becomes a leading "session" field of every JSON reply.
+//
+// Binary frame: u32 payload length, then the payload: u8 message type and its
+// fields. Integers are little-endian; a move is a u16 `from | to << 6 | promotion << 12`
+// (squares a1 = 0 .. h8 = 63, 0 = no move); a string is a u16 length and its bytes;
+// a line is a u8 move count and that many moves.
+//
+//   READY        (1)
+//   NEW_GAME     (2)
+//   MOVE_OK      (3)  u8 side to move (0 white, 1 black)
+//   ILLEGAL_MOVE (4)
+//   POSITION_OK  (5)  u8 side to move, string fen
+//   FEN          (6)  string fen
+//   ERROR        (7)  string message
+//   PONDERING    (8)  move
+//   INFO         (9)  u8 depth, u8 seldepth, i32 score, i16 mate, u64 nodes, u64 nps,
+//                     u16 hashfull, u32 time ms, line pv
+//   BESTMOVE     (10) i32 eval, u8 flags (1 ponderhit, 2 book, 4 cached), move bestmove,
+//                     u8 line count, then per line: i32 score, line
+//   CLOSED       (11)
+//   ROOT_MOVE    (12) i32 score, u64 nodes, string worker, line (root move first)
+//   BENCH        (13) u8 depth, u8 threads, u16 positions, u64 nodes, u32 time ms, u64 nps
+//   STATS        (14) u8 detailed, u8 seldepth, u64 nodes, u64 qsearch nodes, u64 beta cutoffs,
+//                     u64 first-move cutoffs, u64 null-move tries, u64 null-move prunes,
+//                     u64 rfp prunes, u64 lmr reductions, u64 lmr re-searches,
+//                     u64 check extensions, u64 tt probes, u64 tt hits, u64 tt cutoffs,
+//                     u64 evaluations, u8 iteration count, then u32 time ms per iteration
+//   LATENCY      (15) u32 uptime s, u8 histogram count, then per histogram: string name
+//                     (command, "depth <n>" or "nps"), u64 count, u64 mean, u64 p50,
+//                     u64 p95, u64 p99, u64 max (microseconds; nodes per second for "nps")
+class ApiWriter {
+
+    bool binary;
+    int fd;
+    std::mutex* lock;
+    std::string session;
+    std::string buf;
+
+    void begin(uint8_t type);
+    void end();
+
+    void put8(uint8_t v) { buf.push_back((char)v); }
+    void put16(uint16_t v);
+    void put32(uint32_t v);
+    void put64(uint64_t v);
+    void putString(const std::string& s);
+    void putLine(const std::vector<Gen>& line);
+
+    // JSON helpers
+    void jsonString(const std::string& s); // quoted and escaped
+    void jsonLine(const std::vector<Gen>& line);
+
+public:
+
+    enum Type : uint8_t {
+        READY = 1, NEW_GAME, MOVE_OK, ILLEGAL_MOVE, POSITION_OK, FEN, ERROR, PONDERING, INFO, BESTMOVE, CLOSED, ROOT_MOVE, BENCH, STATS, LATENCY
+    };
+
+    explicit ApiWriter(bool binary = false, int fd = STDOUT_FILENO, std::mutex* lock = nullptr, std::string session = "")
+        : binary(binary), fd(fd), lock(lock), session(std::move(session)) {
+        buf.reserve(4096);
+    }
+
+    bool isBinary() const { return binary; }
+
+    static uint16_t packMove(const Gen& move) {
+        return (uint16_t)(move.from | move.to << 6 | (move.promotion ? 1 << 12 : 0));
+    }
+
+    void ready();
+    void newGame();
+    void moveOk(bool whiteToMove);
+    void illegalMove();
+    void positionOk(const std::string& fen, bool whiteToMove);
+    void fen(const std::string& fen);
+    void error(const std::string& message);
+    void pondering(const Gen& move);
+    void info(const SearchInfo& info);
+    void bestmove(int eval, bool ponderhit, bool book, bool cached, const std::vector<ScoredMove>& lines);
+    void closed();
+
+    // One root move finished by a distributed search (see Coordinator.h)
+    void rootMove(int score, long long nodes, const std::string& worker, const std::vector<Gen>& line);
+
+    void bench(const BenchResult& result);
+
+    // Counters of the search behind the bestmove that follows
+    void stats(const SearchStats& stats);
+
+    // Reply to "stats": the non-empty latency and speed distributions
+    void latency(const LatencyStats& latency);
+};
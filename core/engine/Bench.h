@@ -0,0 +1,39 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include "PerfCounters.h"
+
+// Totals of one bench run
+struct BenchResult {
+    int depth = 0;
+    int threads = 0;
+    int positions = 0;
+    long long nodes = 0;  // determinism signature: same build + depth => same count
+    long long timeMs = 0;
+    long long nps = 0;
+    PerfReading perf;     // hardware counters over the whole run, when requested
+};
+
+// Reproducible speed measurement (`--bench`, API "bench"): a fixed search of a built-in
+// suite of positions. Every position starts from a cleared transposition table and
+// cleared histories, so the node total only changes when search behaviour does;
+// threads split the suite between them and leave the total unchanged.
+class Bench {
+public:
+
+    static const int DEFAULT_DEPTH = 6;
+
+    // Searches the suite to `depth` on `threads` threads. `onPosition` (optional) is
+    // called after each position with its suite index, FEN and node count, from the
+    // thread that searched it. With `countEvents`, hardware counters (PerfCounters) are
+    // read around the run.
+    static BenchResult run(int depth, int threads,
+                           std::function<void(int index, const std::string& fen, long long nodes)> onPosition = nullptr,
+                           bool countEvents = false);
+
+    static int suiteSize();
+
+    // FEN of a suite position, 0 <= index < suiteSize()
+    static const char* position(int index);
+};
@@ -0,0 +1,262 @@
+#include "BookBuilder.h"
+#include "../Utils.h"
+#include "../board/Piece.h"
+#include "../board/Check.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+
+// ----------------------------------------------------------
+// SAN -> engine move
+// ----------------------------------------------------------
+bool BookBuilder::resolveSan(Board& b, Generate& g, std::string san, Gen& out) {
+    while (!san.empty() && std::strchr("+#!?", san.back())) san.pop_back();
+    if (san.empty()) return false;
+
+    bool white = b.getTurn();
+    std::array<int8_t, 64>& board = b.getBoard();
+
+    std::vector<Gen> legal;
+    for (Gen& move : g.generate(board, white)) {
+        if (g.makeMove(board, white, move).has_value()) legal.push_back(move);
+    }
+
+    if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+        int from = white ? 4 : 60;
+        int to = san.size() == 3 ? from + 2 : from - 2;
+        for (const Gen& move : legal) {
+            if (move.from == from && move.to == to && std::abs(move.piece) == 6) {
+                out = move;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int type = 1;
+    switch (san[0]) {
+        case 'K': type = 6; break;
+        case 'Q': type = 5; break;
+        case 'R': type = 2; break;
+        case 'B': type = 3; break;
+        case 'N': type = 4; break;
+    }
+    size_t start = type == 1 ? 0 : 1;
+
+    // Promotion, "e8=Q" or "e8Q"; only queens exist in the engine
+    char promoted = 0;
+    size_t eq = san.find('=');
+    if (eq != std::string::npos) {
+        promoted = eq + 1 < san.size() ? san[eq + 1] : '?';
+        san.resize(eq);
+    } else if (type == 1 && san.size() > 2 && std::strchr("QRBN", san.back())) {
+        promoted = san.back();
+        san.pop_back();
+    }
+    if (promoted && promoted != 'Q') return false;
+
+    if (san.size() < start + 2) return false;
+    char file = san[san.size() - 2];
+    char rank = san[san.size() - 1];
+    if (file < 'a' || file > 'h' || rank < '1' || rank > '8') return false;
+    int to = getIndex(san.substr(san.size() - 2));
+
+    // Disambiguation: origin file and/or rank
+    int fromFile = -1, fromRank = -1;
+    for (size_t i = start; i + 2 < san.size(); i++) {
+        char c = san[i];
+        if (c >= 'a' && c <= 'h') fromFile = c - 'a';
+        else if (c >= '1' && c <= '8') fromRank = c - '1';
+        else if (c != 'x' && c != '-') return false;
+    }
+
+    int matches = 0;
+    for (const Gen& move : legal) {
+        if (std::abs(move.piece) != type || move.to != to || move.promotion != (promoted != 0)) continue;
+        if (fromFile >= 0 && move.from % 8 != fromFile) continue;
+        if (fromRank >= 0 && move.from / 8 != fromRank) continue;
+        if (type == 6 && std::abs(move.to - move.from) == 2) continue; // castling is written O-O
+        out = move;
+        matches++;
+    }
+    if (matches == 1) return true;
+    if (matches > 1) return false;
+
+    // En passant onto the empty square; Piece::move checks it against the last double step
+    if (type == 1 && fromFile >= 0 && fromFile != to % 8 && board[to] == 0) {
+        out = Gen{};
+        out.from = (white ? to - 8 : to + 8) - (to % 8) + fromFile;
+        out.to = to;
+        out.piece = white ? 1 : -1;
+        out.pieceTaken = white ? -1 : 1;
+        return true;
+    }
+    return false;
+}
+
+// ----------------------------------------------------------
+// Replaying one game
+// ----------------------------------------------------------
+void BookBuilder::addGame(const std::vector<std::string>& moves, int result) {
+    Board b;
+    Generate g{b};
+    Piece p{b};
+    Check c{b};
+
+    int ply = 0;
+    for (const std::string& san : moves) {
+        if (ply == maxPly) break;
+
+        bool white = b.getTurn();
+        Gen move;
+        if (!resolveSan(b, g, san, move)) break;
+
+        uint64_t key = OpeningBook::key(b);
+        if (!p.move(move.from, move.to)) break;
+        if (c.isCheck(white)) {
+            c.undoMove();
+            break;
+        }
+        if (move.promotion) b.getBoard()[move.to] = white ? 5 : -5;
+
+        int outcome = white ? result : -result;
+        records.push_back({key, OpeningBook::encodeMove(move), (uint32_t)(outcome + 1)});
+
+        b.nextTurn();
+        ply++;
+    }
+
+    if (ply == 0) skipped++;
+    else games++;
+    if (ply > 0 && ply < maxPly && ply < (int)moves.size()) truncated++;
+}
+
+// ----------------------------------------------------------
+// PGN reading: tags, movetext, comments, variations, NAGs
+// ----------------------------------------------------------
+static bool isResult(const std::string& token) {
+    return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+}
+
+static int parseResult(const std::string& s) {
+    if (s == "1-0") return 1;
+    if (s == "0-1") return -1;
+    return 0;
+}
+
+bool BookBuilder::addFile(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) return false;
+
+    std::vector<std::string> moves;
+    int result = 0;
+    bool customStart = false;
+    int variation = 0;
+
+    auto finishGame = [&]() {
+        if (customStart) skipped++;
+        else if (!moves.empty()) addGame(moves, result);
+        moves.clear();
+        result = 0;
+        customStart = false;
+        variation = 0;
+    };
+
+    char ch;
+    while (in.get(ch)) {
+        if (ch == '{') {
+            while (in.get(ch) && ch != '}') {}
+            continue;
+        }
+        if (ch == ';') {
+            std::string rest;
+            std::getline(in, rest);
+            continue;
+        }
+        if (ch == '(') { variation++; continue; }
+        if (ch == ')') { if (variation > 0) variation--; continue; }
+        if (std::isspace((unsigned char)ch)) continue;
+
+        if (ch == '[' && variation == 0) {
+            // Tags start a new game even when the previous one had no result token
+            if (!moves.empty()) finishGame();
+
+            std::string tag;
+            std::getline(in, tag, ']');
+            size_t space = tag.find(' ');
+            size_t open = tag.find('"');
+            size_t close = tag.rfind('"');
+            if (space == std::string::npos || open == std::string::npos || close <= open) continue;
+
+            std::string name = tag.substr(0, space);
+            std::string value = tag.substr(open + 1, close - open - 1);
+            if (name == "Result") result = parseResult(value);
+            if (name == "FEN") customStart = true;
+            continue;
+        }
+
+        std::string token(1, ch);
+        while (in.peek() != EOF && !std::isspace(in.peek()) && !std::strchr("{}();[", in.peek())) {
+            token += (char)in.get();
+        }
+        if (variation > 0 || token[0] == '$') continue;
+
+        if (isResult(token)) {
+            if (token != "*") result = parseResult(token);
+            finishGame();
+            continue;
+        }
+
+        // Move numbers: "12.", "12...", "12.e4"
+        size_t dot = token.find_last_of('.');
+        if (dot != std::string::npos) token = token.substr(dot + 1);
+        if (token.empty() || std::isdigit((unsigned char)token[0])) continue;
+
+        moves.push_back(token);
+    }
+
+    finishGame();
+    return true;
+}
+
+// ----------------------------------------------------------
+// Merging into weighted entries
+// ----------------------------------------------------------
+bool BookBuilder::write(const std::string& path) {
+    std::sort(records.begin(), records.end(), [](const Record& a, const Record& b) {
+        if (a.key != b.key) return a.key < b.key;
+        return a.move < b.move;
+    });
+
+    std::vector<BookEntry> entries;
+    size_t positions = 0;
+    size_t i = 0;
+    while (i < records.size()) {
+        uint64_t key = records[i].key;
+        std::vector<std::pair<uint16_t, uint64_t>> scored;
+
+        while (i < records.size() && records[i].key == key) {
+            uint16_t move = records[i].move;
+            uint64_t score = 0;
+            while (i < records.size() && records[i].key == key && records[i].move == move) {
+                score += records[i++].score;
+            }
+            if (score > 0) scored.push_back({move, score});
+        }
+        if (scored.empty()) continue;
+
+        uint64_t top = 0;
+        for (auto& [move, score] : scored) top = std::max(top, score);
+        for (auto& [move, score] : scored) {
+            uint64_t weight = top > 0xFFFF ? std::max<uint64_t>(1, score * 0xFFFF / top) : score;
+            entries.push_back({key, move, (uint16_t)weight, 0});
+        }
+        positions++;
+    }
+
+    log << games << " games (" << skipped << " skipped, " << truncated << " cut short), "
+        << positions << " positions, " << entries.size() << " book moves\n";
+
+    return OpeningBook::write(path, entries);
+}
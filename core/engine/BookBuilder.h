@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../board/Board.h"
+#include "../board/Generate.h"
+#include "OpeningBook.h"
+
+// Builds an OpeningBook from PGN files.
+//
+// Every game is replayed from the start position through the same move rules as the
+// shell (Piece, Board::nextTurn), so the book keys match the positions the shell probes.
+// Each of the first maxPly moves scores 2 for a win of the side that played it, 1 for
+// a draw or unknown result and 0 for a loss; a position's scores are scaled into the
+// 16-bit weights at the end, and moves that only ever lost are left out.
+// Games from a custom start position (FEN tag), and the rest of a game after a move the
+// engine can't play (underpromotion), are skipped.
+class BookBuilder {
+
+    struct Record {
+        uint64_t key;
+        uint16_t move;
+        uint32_t score;
+    };
+
+    int maxPly;
+    std::ostream& log;
+    std::vector<Record> records;
+
+    long long games = 0;
+    long long skipped = 0;  // custom start position or no playable move
+    long long truncated = 0; // stopped early on an unreadable move
+
+    // result: 1 white won, -1 black won, 0 draw or unknown
+    void addGame(const std::vector<std::string>& moves, int result);
+
+    // Legal move of the side to move matching a SAN token ("Nbd7", "exd6", "O-O", "e8=Q+")
+    static bool resolveSan(Board& b, Generate& g, std::string san, Gen& out);
+
+public:
+
+    static const int DEFAULT_MAX_PLY = 24;
+
+    explicit BookBuilder(int maxPly = DEFAULT_MAX_PLY, std::ostream& log = std::cout)
+        : maxPly(maxPly), log(log) {}
+
+    // Reads every game of a PGN file; false if it can't be opened
+    bool addFile(const std::string& path);
+
+    // Merges the collected moves and writes the book
+    bool write(const std::string& path);
+};
@@ -0,0 +1,374 @@
+#include "Coordinator.h"
+#include "Session.h"
+#include "Trace.h"
+#include "../Utils.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// ----------------------------------------------------------
+// Sockets: "host:port" is TCP, anything else a Unix socket path
+// ----------------------------------------------------------
+static bool isTcp(const std::string& address, std::string& host, std::string& port) {
+    size_t colon = address.rfind(':');
+    if (colon == std::string::npos || address.find('/') != std::string::npos) return false;
+    host = address.substr(0, colon);
+    port = address.substr(colon + 1);
+    return true;
+}
+
+static int tcpSocket(const std::string& host, const std::string& port, bool listening) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (listening) hints.ai_flags = AI_PASSIVE;
+
+    addrinfo* found = nullptr;
+    if (getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &found) != 0) return -1;
+
+    int fd = -1;
+    for (addrinfo* a = found; a && fd < 0; a = a->ai_next) {
+        fd = ::socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd < 0) continue;
+
+        bool ok;
+        if (listening) {
+            int on = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            ok = ::bind(fd, a->ai_addr, a->ai_addrlen) == 0 && ::listen(fd, 16) == 0;
+        } else {
+            ok = ::connect(fd, a->ai_addr, a->ai_addrlen) == 0;
+        }
+        if (!ok) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(found);
+    return fd;
+}
+
+int listenOn(const std::string& address) {
+    std::string host, port;
+    if (isTcp(address, host, port)) return tcpSocket(host, port, true);
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (address.size() >= sizeof(addr.sun_path)) return -1;
+    std::strcpy(addr.sun_path, address.c_str());
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ::unlink(address.c_str());
+    if (fd >= 0 && (::bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(fd, 16) < 0)) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int connectTo(const std::string& address) {
+    std::string host, port;
+    if (isTcp(address, host, port)) return tcpSocket(host, port, false);
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (address.size() >= sizeof(addr.sun_path)) return -1;
+    std::strcpy(addr.sun_path, address.c_str());
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && ::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool sendLine(int fd, std::string line) {
+    line.push_back('\n');
+    size_t done = 0;
+    while (done < line.size()) {
+        ssize_t n = ::write(fd, line.data() + done, line.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += (size_t)n;
+    }
+    return true;
+}
+
+bool LineReader::next(std::string& line) {
+    char chunk[4096];
+    size_t newline;
+    while ((newline = buffer.find('\n')) == std::string::npos) {
+        ssize_t n = ::read(fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        buffer.append(chunk, (size_t)n);
+    }
+    line = buffer.substr(0, newline);
+    buffer.erase(0, newline + 1);
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    return true;
+}
+
+static std::string moveString(const Gen& move) {
+    return indexToAlgebraic(move.from) + indexToAlgebraic(move.to) + (move.promotion ? "q" : "");
+}
+
+static bool parseMove(const std::string& text, Gen& move) {
+    if (text.size() < 4 || text.size() > 5) return false;
+    for (int i : {0, 2}) {
+        if (text[i] < 'a' || text[i] > 'h' || text[i + 1] < '1' || text[i + 1] > '8') return false;
+    }
+    move = Gen{};
+    move.from = getIndex(text.substr(0, 2));
+    move.to = getIndex(text.substr(2, 2));
+    move.promotion = text.size() == 5;
+    return true;
+}
+
+// ----------------------------------------------------------
+// Worker: one root move per request
+// ----------------------------------------------------------
+SplitWorker::SplitWorker(std::string address, int hashMB)
+    : address(std::move(address)), tt(std::max(hashMB, 1)) {
+    tt.attachSharedFromEnvironment();
+
+    const char* dir = std::getenv("CHESS_TABLEBASES");
+    tablebase.open(dir ? dir : "tablebases");
+}
+
+bool SplitWorker::searchRootMove(Search& s, Board& board, const std::string& move, int depth,
+                                 int& score, std::vector<Gen>& pv) {
+    if (!playCoordinateMove(board, move)) return false;
+
+    pv.clear();
+    s.clearStop();
+    int reply = s.searchPV(board.getBoard(), std::max(depth - 1, 1), board.getTurn(), -2000000, 2000000, pv);
+
+    // Mate scores count plies from the searched position: one more from the root
+    score = -reply;
+    if (score > 0 && Search::mateDistance(score - 1) > 0) score--;
+    else if (score < 0 && Search::mateDistance(score + 1) < 0) score++;
+    return true;
+}
+
+int SplitWorker::run() {
+    // A coordinator that goes away mid-reply must not kill the worker
+    std::signal(SIGPIPE, SIG_IGN);
+
+    int listenFd = listenOn(address);
+    if (listenFd < 0) {
+        std::cerr << "cannot listen on " << address << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    std::cerr << "split worker listening on " << address << "\n";
+
+    for (;;) {
+        int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            std::cerr << "accept: " << std::strerror(errno) << "\n";
+            break;
+        }
+        std::thread(&SplitWorker::serve, this, fd).detach();
+    }
+
+    ::close(listenFd);
+    return 1;
+}
+
+void SplitWorker::serve(int fd) {
+    Trace::threadName("split worker");
+    SearchWorker w(tt, tablebase.maxPieces() > 0 ? &tablebase : nullptr);
+    Board root;
+    LineReader in(fd);
+    std::string line;
+
+    while (in.next(line)) {
+        std::istringstream words(line);
+        std::string cmd;
+        if (!(words >> cmd)) continue;
+
+        std::string reply;
+        if (cmd == "position") {
+            std::string spec, error;
+            std::getline(words >> std::ws, spec);
+            reply = setupPosition(root, spec, error) ? "ok" : "error " + error;
+        }
+        else if (cmd == "search") {
+            int depth = 0;
+            std::string move;
+            words >> depth >> move;
+
+            int score = 0;
+            std::vector<Gen> pv;
+            w.board = root;
+            if (depth < 1 || !searchRootMove(w.s, w.board, move, depth, score, pv)) {
+                reply = "error illegal_move " + move;
+            } else {
+                reply = "result " + std::to_string(score) + " " + std::to_string(w.s.getNodesSearched());
+                for (const Gen& m : pv) reply += " " + moveString(m);
+            }
+        }
+        else if (cmd == "quit") {
+            break;
+        }
+        else {
+            reply = "error unknown_command";
+        }
+
+        if (!sendLine(fd, reply)) break;
+    }
+    ::close(fd);
+}
+
+// ----------------------------------------------------------
+// Coordinator
+// ----------------------------------------------------------
+Coordinator::Coordinator(std::vector<std::string> workers, int depth)
+    : workers(std::move(workers)), depth(std::max(depth, 1)) {}
+
+bool Coordinator::next(Gen& move) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (queue.empty()) return false;
+    move = queue.front();
+    queue.pop_front();
+    return true;
+}
+
+void Coordinator::finish(const RootResult& result, const std::string& worker) {
+    std::lock_guard<std::mutex> lock(mutex);
+    results.push_back(result);
+
+    bool white = b.getTurn();
+    out.rootMove(white ? result.score : -result.score, result.nodes, worker, result.pv);
+}
+
+void Coordinator::drive(const std::string& address, const std::string& spec) {
+    Trace::threadName("coordinator link");
+    int fd = connectTo(address);
+    if (fd < 0) {
+        std::cerr << "worker " << address << " unreachable\n";
+        return;
+    }
+
+    LineReader in(fd);
+    std::string reply;
+    if (!sendLine(fd, "position " + spec) || !in.next(reply) || reply != "ok") {
+        std::cerr << "worker " << address << " refused the position\n";
+        ::close(fd);
+        return;
+    }
+
+    Gen move;
+    while (next(move)) {
+        bool done = false;
+        RootResult result;
+        result.move = move;
+
+        if (sendLine(fd, "search " + std::to_string(depth) + " " + moveString(move)) && in.next(reply)) {
+            std::istringstream words(reply);
+            std::string kind, token;
+            words >> kind >> result.score >> result.nodes;
+            if (kind == "result" && words) {
+                done = true;
+                result.pv.push_back(move);
+                Gen m;
+                while (words >> token && parseMove(token, m)) result.pv.push_back(m);
+            }
+        }
+
+        if (!done) {
+            // Hand the move back for the remaining workers and give up on this one
+            std::cerr << "worker " << address << " failed on " << moveString(move) << "\n";
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_front(move);
+            break;
+        }
+        finish(result, address);
+    }
+
+    sendLine(fd, "quit");
+    ::close(fd);
+}
+
+Coordinator::RootResult Coordinator::searchLocally(const Gen& move) {
+    RootResult result;
+    result.move = move;
+
+    Board root = b;
+    std::vector<Gen> pv;
+    SplitWorker::searchRootMove(s, b, moveString(move), depth, result.score, pv);
+    result.nodes = s.getNodesSearched();
+    b = root;
+
+    result.pv.push_back(move);
+    result.pv.insert(result.pv.end(), pv.begin(), pv.end());
+    return result;
+}
+
+int Coordinator::run(const std::string& spec) {
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::string error;
+    if (!setupPosition(b, spec, error)) {
+        out.error(error);
+        return 1;
+    }
+    bool white = b.getTurn();
+
+    // Most promising moves first, by a shallow local search: they take longest and
+    // should be running while the rest are shared out
+    std::vector<ScoredMove> ordered = s.getTopMoves(b.getBoard(), std::min(depth, 3), white, 256);
+    for (const ScoredMove& line : ordered) {
+        if (!line.line.empty()) queue.push_back(line.line[0]);
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (const std::string& address : workers) {
+        threads.emplace_back(&Coordinator::drive, this, address, spec);
+    }
+    for (std::thread& t : threads) t.join();
+
+    // Every worker failed or went away: finish here
+    Gen move;
+    while (next(move)) finish(searchLocally(move), "local");
+
+    long long nodes = 0;
+    for (const RootResult& r : results) nodes += r.nodes;
+    long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count();
+    std::cerr << results.size() << " root moves, " << nodes << " nodes in " << ms << " ms\n";
+
+    // Best first for the side to move; reported white-relative like the API
+    std::sort(results.begin(), results.end(), [](const RootResult& x, const RootResult& y) {
+        return x.score > y.score;
+    });
+
+    std::vector<ScoredMove> lines;
+    for (size_t i = 0; i < results.size() && i < 3; i++) {
+        lines.push_back({results[i].pv, white ? results[i].score : -results[i].score});
+    }
+
+    // No legal moves: the position's own score
+    int eval;
+    if (!results.empty()) {
+        eval = lines[0].score;
+    } else {
+        eval = s.search(b.getBoard(), 1, white, -2000000, 2000000);
+        if (!white) eval = -eval;
+    }
+
+    out.bestmove(eval, false, false, false, lines);
+    return 0;
+}
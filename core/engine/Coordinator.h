@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../board/Board.h"
+#include "../board/Generate.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+#include "Tablebase.h"
+#include "ApiWriter.h"
+
+// Root splitting across engine processes.
+//
+// A SplitWorker (--worker <address>) searches single root moves on request. The
+// Coordinator (--coordinate) takes a position, queues its root moves (most promising
+// first) and hands them to its workers one at a time: a worker that finishes takes the
+// next move, so fast workers and cheap moves balance out. A move whose worker drops
+// goes back to the queue; moves left when every worker is gone are searched locally.
+//
+// Addresses are Unix socket paths, or host:port for TCP to spread over machines.
+// Worker protocol, one line each way:
+//   position <spec>          -> ok | error <message>
+//   search <depth> <move>    -> result <score> <nodes> [pv...] | error <message>
+// The score is from the root side to move's view; the pv starts after <move>.
+
+// Listening or connected socket for an address; -1 on failure
+int listenOn(const std::string& address);
+int connectTo(const std::string& address);
+
+// Buffered line reading from a socket
+class LineReader {
+    int fd;
+    std::string buffer;
+public:
+    explicit LineReader(int fd) : fd(fd) {}
+    bool next(std::string& line);
+};
+
+class SplitWorker {
+
+    std::string address;
+    TranspositionTable tt;
+    Tablebase tablebase;
+
+    void serve(int fd);
+
+public:
+
+    SplitWorker(std::string address, int hashMB);
+
+    // Plays `move` on `board` (the board `s` searches) and searches the reply to make
+    // `depth` plies in total. `score` is from the mover's view, `pv` the line after the
+    // move. False if the move is illegal. Shared with the coordinator's local fallback.
+    static bool searchRootMove(Search& s, Board& board, const std::string& move, int depth,
+                               int& score, std::vector<Gen>& pv);
+
+    // Serves coordinators until the socket fails; returns the process exit code
+    int run();
+};
+
+class Coordinator {
+
+    struct RootResult {
+        Gen move;
+        int score = 0;        // root side to move's view
+        long long nodes = 0;
+        std::vector<Gen> pv;  // from the root, starting with `move`
+    };
+
+    std::vector<std::string> workers;
+    int depth;
+    Board b;
+
+    // Orders the root moves and searches any the workers leave behind
+    TranspositionTable tt;
+    Generate g{b};
+    Search s{b, g, tt};
+
+    ApiWriter out;
+
+    // Root moves waiting for a worker, and finished ones
+    std::mutex mutex;
+    std::deque<Gen> queue;
+    std::vector<RootResult> results;
+
+    // Feeds one worker until the queue is empty or the worker fails
+    void drive(const std::string& address, const std::string& spec);
+
+    // Takes the next root move; false once none are left
+    bool next(Gen& move);
+
+    RootResult searchLocally(const Gen& move);
+    void finish(const RootResult& result, const std::string& worker);
+
+public:
+
+    Coordinator(std::vector<std::string> workers, int depth);
+
+    // Splits the search of `spec` ("startpos ...", "fen ...") and prints the result.
+    // Returns the process exit code.
+    int run(const std::string& spec);
+};
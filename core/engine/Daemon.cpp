@@ -0,0 +1,208 @@
+#include "Daemon.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static const size_t MAX_SESSION_ID = 64;
+
+Daemon::Connection::~Connection() {
+    ::close(fd);
+}
+
+Daemon::Client::Client(std::shared_ptr<Connection> conn, const std::string& id, Daemon& d)
+    : conn(conn),
+      out(false, conn->fd, &conn->writeMutex, id),
+      session(out, d.tt, d.tablebase.maxPieces() > 0 ? &d.tablebase : nullptr, &d.book,
+              d.cache.isOpen() ? &d.cache : nullptr, &d.latency, false) {}
+
+// --------------------------------------------------------
+// Tablebases, book, shared hash and analysis cache as in API mode
+// ($CHESS_TABLEBASES, $CHESS_BOOK, $CHESS_SHARED_HASH, $CHESS_ANALYSIS_CACHE)
+// --------------------------------------------------------
+Daemon::Daemon(std::string path, int workers, int maxSessions, int hashMB)
+    : path(std::move(path)), workers(std::max(workers, 1)), maxSessions(std::max(maxSessions, 1)),
+      tt(std::max(hashMB, 1)) {
+    tt.attachSharedFromEnvironment();
+
+    const char* dir = std::getenv("CHESS_TABLEBASES");
+    tablebase.open(dir ? dir : "tablebases");
+
+    const char* bookPath = std::getenv("CHESS_BOOK");
+    book.open(bookPath ? bookPath : "book.bin");
+
+    cache.openFromEnvironment();
+}
+
+int Daemon::run() {
+    // A client that disconnects mid-reply must not kill the daemon
+    std::signal(SIGPIPE, SIG_IGN);
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "socket path too long: " << path << "\n";
+        return 1;
+    }
+    std::strcpy(addr.sun_path, path.c_str());
+
+    int listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ::unlink(path.c_str());
+    if (listenFd < 0 || ::bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(listenFd, 64) < 0) {
+        std::cerr << "cannot listen on " << path << ": " << std::strerror(errno) << "\n";
+        if (listenFd >= 0) ::close(listenFd);
+        return 1;
+    }
+
+    std::cerr << "listening on " << path << " (" << workers << " workers, up to "
+              << maxSessions << " sessions)\n";
+
+    scheduler = std::make_unique<Scheduler>(workers, tt, tablebase.maxPieces() > 0 ? &tablebase : nullptr);
+
+    for (;;) {
+        int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            std::cerr << "accept: " << std::strerror(errno) << "\n";
+            break;
+        }
+        std::thread(&Daemon::serve, this, std::make_shared<Connection>(fd)).detach();
+    }
+
+    ::close(listenFd);
+    ::unlink(path.c_str());
+    return 1;
+}
+
+// ----------------------------------------------------------
+// Connection reader: "<session-id> <command>" lines
+// ----------------------------------------------------------
+static bool validSessionId(const std::string& id) {
+    if (id.empty() || id.size() > MAX_SESSION_ID) return false;
+    return std::all_of(id.begin(), id.end(), [](unsigned char c) {
+        return std::isalnum(c) || c == '-' || c == '_' || c == '.';
+    });
+}
+
+void Daemon::serve(std::shared_ptr<Connection> conn) {
+    Trace::threadName("daemon connection");
+
+    // Sessions opened on this connection. Ids are only looked up here, so a line can
+    // never reach a session another connection opened, even one with the same id.
+    std::map<std::string, std::shared_ptr<Client>> clients;
+    std::string input;
+    char chunk[4096];
+
+    for (;;) {
+        ssize_t n = ::read(conn->fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        input.append(chunk, (size_t)n);
+
+        size_t start = 0, newline;
+        while ((newline = input.find('\n', start)) != std::string::npos) {
+            std::string line = input.substr(start, newline - start);
+            start = newline + 1;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+
+            size_t space = line.find(' ');
+            std::string id = line.substr(0, space);
+            std::string command = space == std::string::npos ? "" : line.substr(space + 1);
+            if (id.empty()) continue;
+
+            if (!validSessionId(id)) {
+                ApiWriter(false, conn->fd, &conn->writeMutex).error("bad_session_id");
+                continue;
+            }
+
+            // A stray carriage return would let a relaying client (the web server) pass
+            // one user's text as the start of a line of another session
+            if (std::any_of(command.begin(), command.end(), [](unsigned char c) { return c < 0x20 && c != '\t'; })) {
+                ApiWriter(false, conn->fd, &conn->writeMutex, id).error("bad_command");
+                continue;
+            }
+
+            auto it = clients.find(id);
+            if (command == "close" || command == "quit") {
+                if (it != clients.end()) {
+                    closeClient(it->second);
+                    it->second->out.closed();
+                    clients.erase(it);
+                }
+                continue;
+            }
+
+            if (it == clients.end()) {
+                {
+                    std::lock_guard<std::mutex> lock(queueMutex);
+                    if (sessions < maxSessions) sessions++;
+                    else id.clear();
+                }
+                if (id.empty()) {
+                    ApiWriter(false, conn->fd, &conn->writeMutex, line.substr(0, space)).error("too_many_sessions");
+                    continue;
+                }
+                it = clients.emplace(id, std::make_shared<Client>(conn, id, *this)).first;
+            }
+
+            if (!submit(it->second, command)) it->second->out.error("queue_full");
+        }
+        input.erase(0, start);
+    }
+
+    for (auto& [id, client] : clients) closeClient(client);
+}
+
+void Daemon::closeClient(const std::shared_ptr<Client>& client) {
+    client->session.abort();
+
+    std::lock_guard<std::mutex> lock(queueMutex);
+    client->closed = true;
+    client->pending.clear();
+    sessions--;
+}
+
+// ----------------------------------------------------------
+// Command queues, drained by scheduler tasks
+// ----------------------------------------------------------
+bool Daemon::submit(const std::shared_ptr<Client>& client, const std::string& line) {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    if (client->pending.size() >= MAX_PENDING) return false;
+
+    client->pending.push_back(line);
+    if (!client->scheduled) {
+        client->scheduled = true;
+        scheduler->spawn(drain(client));
+    }
+    return true;
+}
+
+Task Daemon::drain(std::shared_ptr<Client> client) {
+    for (;;) {
+        std::string line;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if (client->closed || client->pending.empty()) {
+                client->scheduled = false;
+                co_return;
+            }
+            line = std::move(client->pending.front());
+            client->pending.pop_front();
+        }
+
+        co_await client->session.run(line, *scheduler);
+
+        // Back of the queue: every waiting session gets a turn before this one again
+        co_await scheduler->yield();
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "TranspositionTable.h"
+#include "Tablebase.h"
+#include "OpeningBook.h"
+#include "AnalysisCache.h"
+#include "Session.h"
+#include "Scheduler.h"
+
+// Engine daemon (--daemon): one process serving many API sessions over a Unix socket.
+//
+// Clients send "<session-id> <command>" lines, with the commands of the --api protocol;
+// a session is opened by its first command and ended by "<session-id> close" or when its
+// connection goes away. Replies are the usual JSON lines with a leading "session" field.
+// Sessions keep their own board and game state but share the transposition table,
+// tablebases, book and a fixed pool of search workers.
+//
+// Fairness: a session runs at most one command at a time. Sessions with queued commands
+// are tasks of a cooperative Scheduler: they take turns on its thread pool, and a search
+// gives its thread back after every time slice, so short requests stay quick while long
+// analyses run. The pool size bounds the number of concurrent searches; pondering and
+// "bench" are not available.
+class Daemon {
+
+    // Client socket; closed once neither the reader nor a queued session needs it
+    struct Connection {
+        int fd;
+        std::mutex writeMutex;
+        explicit Connection(int fd) : fd(fd) {}
+        ~Connection();
+    };
+
+    struct Client {
+        std::shared_ptr<Connection> conn;
+        ApiWriter out;
+        Session session;
+
+        // Guarded by queueMutex
+        std::deque<std::string> pending;
+        bool scheduled = false; // a drain() task is queued or running
+        bool closed = false;
+
+        Client(std::shared_ptr<Connection> conn, const std::string& id, Daemon& d);
+    };
+
+    std::string path;
+    int workers;
+    int maxSessions;
+
+    TranspositionTable tt;
+    Tablebase tablebase;
+    OpeningBook book;
+    AnalysisCache cache;
+
+    // Command latencies of all sessions ("stats")
+    LatencyStats latency;
+
+    // Started by run()
+    std::unique_ptr<Scheduler> scheduler;
+
+    std::mutex queueMutex;
+    int sessions = 0;
+
+    // Reads one connection's lines until it closes
+    void serve(std::shared_ptr<Connection> conn);
+
+    // Scheduler task: runs the session's queued commands, yielding between them
+    Task drain(std::shared_ptr<Client> client);
+
+    // Queues a command line for the session, scheduling it if idle.
+    // False if too many commands are already waiting.
+    bool submit(const std::shared_ptr<Client>& client, const std::string& line);
+
+    void closeClient(const std::shared_ptr<Client>& client);
+
+public:
+
+    // Commands a session may have waiting before new ones are refused
+    static const size_t MAX_PENDING = 64;
+
+    Daemon(std::string path, int workers, int maxSessions, int hashMB);
+
+    // Listens until the socket fails; returns the process exit code
+    int run();
+};
@@ -1,5 +1,6 @@
 
 #include "Evaluation.h"
+#include "Trace.h"
 #include <cmath>
 
 static inline bool onBoard(int r, int c) {
@@ -448,6 +449,7 @@ int Evaluation::getScore(const std::array<int8_t, 64>& board, int idx) {
 // Full board evaluation
 // --------------------------------------------------------
 int Evaluation::evaluation(const std::array<std::int8_t, 64>& board) {
+    TraceSample sample("Evaluation::evaluation");
     int score = 0;
     for (int i = 0; i < 64; ++i) {
         score += getScore(board, i);
@@ -6,6 +6,8 @@
 
 class Evaluation {
 
+    // Kernel microbenchmarks (core/bench/MicroBench.cpp) time isAttacked directly
+    friend class MicroBench;
 
     // Pawn positional scores
     int pawnEval[8][8] = {
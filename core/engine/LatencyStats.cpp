@@ -0,0 +1,86 @@
+#include "LatencyStats.h"
+#include <algorithm>
+#include <cmath>
+
+// ----------------------------------------------------------
+// Histogram: bucket b < 32 holds the value b; above, each power of two
+// [2^k, 2^(k+1)) is split into SUB_BUCKETS equal buckets
+// ----------------------------------------------------------
+int Histogram::bucketOf(uint64_t value) {
+    if (value < 2 * SUB_BUCKETS) return (int)value;
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - 4;
+    int sub = (int)(value >> shift); // SUB_BUCKETS .. 2 * SUB_BUCKETS - 1
+    return 2 * SUB_BUCKETS + (shift - 1) * SUB_BUCKETS + (sub - SUB_BUCKETS);
+}
+
+uint64_t Histogram::bucketTop(int bucket) {
+    if (bucket < 2 * SUB_BUCKETS) return (uint64_t)bucket;
+    int shift = (bucket - 2 * SUB_BUCKETS) / SUB_BUCKETS + 1;
+    uint64_t sub = (uint64_t)((bucket - 2 * SUB_BUCKETS) % SUB_BUCKETS + SUB_BUCKETS);
+    return ((sub + 1) << shift) - 1;
+}
+
+void Histogram::record(uint64_t value) {
+    buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t seen = maximum.load(std::memory_order_relaxed);
+    while (value > seen && !maximum.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+}
+
+uint64_t Histogram::mean() const {
+    uint64_t n = count();
+    return n > 0 ? sum.load(std::memory_order_relaxed) / n : 0;
+}
+
+uint64_t Histogram::percentile(double p) const {
+    uint64_t n = count();
+    if (n == 0) return 0;
+
+    uint64_t rank = std::max<uint64_t>((uint64_t)std::ceil(p / 100.0 * (double)n), 1);
+    uint64_t seen = 0;
+    for (int b = 0; b < BUCKETS; b++) {
+        seen += buckets[b].load(std::memory_order_relaxed);
+        if (seen >= rank) return std::min(bucketTop(b), max());
+    }
+    return max();
+}
+
+// ----------------------------------------------------------
+// Per-command latencies
+// ----------------------------------------------------------
+static const char* const COMMAND_NAMES[LatencyStats::COMMANDS] = {
+    "isready", "newgame", "position", "fen", "move", "search", "bench", "ponder", "stats"
+};
+
+LatencyStats::Command LatencyStats::commandOf(const std::string& keyword) {
+    for (int c = 0; c < COMMANDS; c++) {
+        if (keyword == COMMAND_NAMES[c]) return (Command)c;
+    }
+    return COMMANDS;
+}
+
+const char* LatencyStats::name(Command c) {
+    return COMMAND_NAMES[c];
+}
+
+static uint64_t microsecondsSince(std::chrono::steady_clock::time_point since) {
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - since).count();
+    return (uint64_t)std::max<long long>(us, 0);
+}
+
+void LatencyStats::record(Command c, std::chrono::steady_clock::time_point since) {
+    if (c < COMMANDS) commands[c].record(microsecondsSince(since));
+}
+
+void LatencyStats::recordSearch(int depth, long long nodes, std::chrono::steady_clock::time_point since) {
+    uint64_t us = microsecondsSince(since);
+    depths[std::clamp(depth, 1, MAX_DEPTH) - 1].record(us);
+    speed.record((uint64_t)std::max(nodes, 0LL) * 1000000 / std::max<uint64_t>(us, 1));
+}
+
+long long LatencyStats::uptimeSeconds() const {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - started).count();
+}
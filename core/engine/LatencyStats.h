@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Distribution of non-negative values in log-linear buckets (HDR histogram style):
+// exact below 32, then 16 buckets per power of two, so a reported percentile is at
+// most 1/16 above the recorded value. Recording is a few relaxed atomic adds, safe
+// from any number of threads.
+class Histogram {
+
+    static const int SUB_BUCKETS = 16;
+    static const int BUCKETS = 2 * SUB_BUCKETS + 59 * SUB_BUCKETS;
+
+    std::atomic<uint64_t> buckets[BUCKETS] = {};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> maximum{0};
+
+    static int bucketOf(uint64_t value);
+
+    // Largest value that falls in the bucket
+    static uint64_t bucketTop(int bucket);
+
+public:
+
+    void record(uint64_t value);
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t max() const { return maximum.load(std::memory_order_relaxed); }
+    uint64_t mean() const;
+
+    // Smallest bucket bound with at least `p` (0..100) percent of the values at or
+    // below it; 0 when empty
+    uint64_t percentile(double p) const;
+};
+
+// Per-command latency of the --api protocol and the daemon, kept for the life of the
+// process and reported by the "stats" command. Latencies are in microseconds from the
+// start of a command to its last reply; searches are also broken down by depth, with
+// their speed in nodes per second.
+class LatencyStats {
+public:
+
+    // Commands timed (anything else is not recorded)
+    enum Command { ISREADY, NEWGAME, POSITION, FEN, MOVE, SEARCH, BENCH, PONDER, STATS, COMMANDS };
+
+    // Searches deeper than this are counted with it
+    static const int MAX_DEPTH = 32;
+
+    LatencyStats() : started(std::chrono::steady_clock::now()) {}
+
+    LatencyStats(const LatencyStats&) = delete;
+    LatencyStats& operator=(const LatencyStats&) = delete;
+
+    // Command of a protocol keyword, COMMANDS if not timed
+    static Command commandOf(const std::string& keyword);
+    static const char* name(Command c);
+
+    void record(Command c, std::chrono::steady_clock::time_point since);
+
+    // A search that ran (not a book move, ponder hit or cached answer)
+    void recordSearch(int depth, long long nodes, std::chrono::steady_clock::time_point since);
+
+    const Histogram& command(Command c) const { return commands[c]; }
+    const Histogram& depth(int d) const { return depths[d - 1]; } // 1 <= d <= MAX_DEPTH
+    const Histogram& nps() const { return speed; }
+
+    long long uptimeSeconds() const;
+
+private:
+
+    std::chrono::steady_clock::time_point started;
+    Histogram commands[COMMANDS];
+    Histogram depths[MAX_DEPTH];
+    Histogram speed;
+};
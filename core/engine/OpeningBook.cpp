@@ -0,0 +1,165 @@
+#include "OpeningBook.h"
+#include "../board/Zobrist.h"
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ----------------------------------------------------------
+// Big-endian fields
+// ----------------------------------------------------------
+static uint64_t readBE(const uint8_t* p, int bytes) {
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; i++) v = (v << 8) | p[i];
+    return v;
+}
+
+static void writeBE(uint8_t* p, uint64_t v, int bytes) {
+    for (int i = bytes - 1; i >= 0; i--) {
+        p[i] = static_cast<uint8_t>(v);
+        v >>= 8;
+    }
+}
+
+BookEntry OpeningBook::entryAt(size_t i) const {
+    const uint8_t* p = base + i * ENTRY_SIZE;
+    return {readBE(p, 8), (uint16_t)readBE(p + 8, 2), (uint16_t)readBE(p + 10, 2), (uint32_t)readBE(p + 12, 4)};
+}
+
+// ----------------------------------------------------------
+// Keys and moves
+// ----------------------------------------------------------
+uint64_t OpeningBook::key(Board& b) {
+    return hashBoard(b.getBoard(), b.getTurn()) ^ hashCastling(b);
+}
+
+uint16_t OpeningBook::encodeMove(const Gen& move) {
+    int from = move.from;
+    int to = move.to;
+
+    // Castling is stored as the king capturing its own rook
+    if (std::abs(move.piece) == 6 && std::abs(to - from) == 2) {
+        to = to > from ? from + 3 : from - 4;
+    }
+
+    int promotion = move.promotion ? 4 : 0; // queen
+    return (uint16_t)((to & 7) | ((to >> 3) << 3) | ((from & 7) << 6) | ((from >> 3) << 9) | (promotion << 12));
+}
+
+// ----------------------------------------------------------
+// Writing
+// ----------------------------------------------------------
+bool OpeningBook::write(const std::string& path, std::vector<BookEntry>& entries) {
+    std::sort(entries.begin(), entries.end(), [](const BookEntry& a, const BookEntry& b) {
+        if (a.key != b.key) return a.key < b.key;
+        return a.weight > b.weight;
+    });
+
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+
+    std::vector<uint8_t> out(entries.size() * ENTRY_SIZE);
+    for (size_t i = 0; i < entries.size(); i++) {
+        uint8_t* p = out.data() + i * ENTRY_SIZE;
+        writeBE(p, entries[i].key, 8);
+        writeBE(p + 8, entries[i].move, 2);
+        writeBE(p + 10, entries[i].weight, 2);
+        writeBE(p + 12, entries[i].learn, 4);
+    }
+
+    bool ok = std::fwrite(out.data(), 1, out.size(), f) == out.size();
+    return std::fclose(f) == 0 && ok;
+}
+
+// ----------------------------------------------------------
+// Probing
+// ----------------------------------------------------------
+bool OpeningBook::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0 || st.st_size % ENTRY_SIZE != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* mem = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED) return false;
+
+    base = static_cast<const uint8_t*>(mem);
+    length = st.st_size;
+    count = length / ENTRY_SIZE;
+    return true;
+}
+
+void OpeningBook::close() {
+    if (base) munmap(const_cast<uint8_t*>(base), length);
+    base = nullptr;
+    length = 0;
+    count = 0;
+}
+
+std::vector<BookMove> OpeningBook::probe(Board& b, Generate& g) const {
+    std::vector<BookMove> found;
+    if (!base) return found;
+
+    // First entry of the position
+    uint64_t k = key(b);
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (readBE(base + mid * ENTRY_SIZE, 8) < k) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == count || readBE(base + lo * ENTRY_SIZE, 8) != k) return found;
+
+    // Book moves are matched against the legal moves, which also guards against key collisions
+    bool white = b.getTurn();
+    std::vector<Gen> legal;
+    for (Gen& move : g.generate(b.getBoard(), white)) {
+        if (g.makeMove(b.getBoard(), white, move).has_value()) legal.push_back(move);
+    }
+
+    for (size_t i = lo; i < count; i++) {
+        BookEntry e = entryAt(i);
+        if (e.key != k) break;
+        if (e.weight == 0) continue;
+
+        for (const Gen& move : legal) {
+            if (encodeMove(move) == e.move) {
+                found.push_back({move, e.weight});
+                break;
+            }
+        }
+    }
+
+    std::stable_sort(found.begin(), found.end(), [](const BookMove& a, const BookMove& b) {
+        return a.weight > b.weight;
+    });
+    return found;
+}
+
+bool OpeningBook::pick(Board& b, Generate& g, Gen& out) {
+    std::vector<BookMove> moves = probe(b, g);
+    if (moves.empty()) return false;
+
+    int total = 0;
+    for (const BookMove& m : moves) total += m.weight;
+
+    int r = std::uniform_int_distribution<int>(0, total - 1)(rng);
+    for (const BookMove& m : moves) {
+        if (r < m.weight) {
+            out = m.move;
+            return true;
+        }
+        r -= m.weight;
+    }
+    out = moves[0].move;
+    return true;
+}
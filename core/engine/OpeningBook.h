@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+#include "../board/Board.h"
+#include "../board/Generate.h"
+
+// One book entry, stored on disk as 16 big-endian bytes (Polyglot layout):
+// key, move, weight, learn. Entries are sorted by key, so all moves of a
+// position are adjacent and found by binary search.
+struct BookEntry {
+    uint64_t key;
+    uint16_t move;
+    uint16_t weight;
+    uint32_t learn;
+};
+
+struct BookMove {
+    Gen move;
+    int weight;
+};
+
+// Read-only opening book, memory-mapped. Built offline from PGN files with BookBuilder.
+//
+// Moves use the Polyglot encoding (to file, to rank, from file, from rank, promotion
+// in 3-bit fields; castling as king takes own rook). Positions are keyed with the
+// engine's own Zobrist keys (placement, side to move, castling rights), the same key
+// the search uses, so books are only interchangeable between builds of this engine.
+class OpeningBook {
+
+    const uint8_t* base = nullptr;
+    size_t length = 0;
+    size_t count = 0;
+
+    std::mt19937 rng{std::random_device{}()};
+
+    BookEntry entryAt(size_t i) const;
+
+public:
+
+    static const size_t ENTRY_SIZE = 16;
+
+    OpeningBook() = default;
+    ~OpeningBook() { close(); }
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+
+    // Key of the game position: placement, side to move and castling rights
+    static uint64_t key(Board& b);
+
+    // Polyglot move code of an engine move
+    static uint16_t encodeMove(const Gen& move);
+
+    // Sorts `entries` by key and writes them out in the on-disk layout
+    static bool write(const std::string& path, std::vector<BookEntry>& entries);
+
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return base != nullptr; }
+    size_t size() const { return count; }
+
+    // Legal book moves of the game position, heaviest first. Empty when out of book.
+    // `g` must generate for `b` (castling rights are taken from the board).
+    std::vector<BookMove> probe(Board& b, Generate& g) const;
+
+    // Weighted random choice among the book moves; false when out of book
+    bool pick(Board& b, Generate& g, Gen& out);
+};
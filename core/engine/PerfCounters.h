@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+// Counts of one measured region; an event the system couldn't count is not valid
+struct PerfReading {
+    static const int EVENTS = 5;
+    uint64_t value[EVENTS] = {};
+    bool valid[EVENTS] = {};
+
+    bool any() const {
+        for (bool v : valid) if (v) return true;
+        return false;
+    }
+};
+
+// Hardware performance counters of the calling thread and the threads it creates
+// afterwards, through Linux perf_event_open (user space only). Events that can't be
+// opened (no PMU, perf_event_paranoid, seccomp in containers, other systems) simply
+// read as not valid. Counts are scaled when the kernel multiplexed the counters.
+class PerfCounters {
+
+    int fds[PerfReading::EVENTS];
+
+public:
+
+    enum Event { CYCLES, INSTRUCTIONS, BRANCH_MISSES, L1D_MISSES, LLC_MISSES };
+
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // At least one event can be counted
+    bool available() const;
+
+    // Zeroes and starts the counters
+    void start();
+
+    // Stops the counters and reads them
+    PerfReading stop();
+
+    // Short event name ("cycles", "instructions", ...)
+    static const char* name(int event);
+};
@@ -0,0 +1,57 @@
+#include "Ponder.h"
+#include "Trace.h"
+#include "../board/Piece.h"
+
+bool Ponder::start(const Board& root, const Gen& reply, int searchDepth, int lineCount) {
+    cancel();
+
+    board = root;
+    Piece p{board};
+    if (!p.move(reply.from, reply.to)) return false;
+    board.nextTurn();
+
+    expected = reply;
+    depth = searchDepth;
+    topN = lineCount;
+    score = 0;
+    lines.clear();
+
+    finished.store(false);
+    s.clearStop();
+    started = std::chrono::steady_clock::now();
+    active = true;
+
+    worker = std::thread(&Ponder::run, this);
+    return true;
+}
+
+void Ponder::run() {
+    Trace::threadName("ponder");
+    bool white = board.getTurn();
+
+    // Same work the engine does when it is its turn, so a hit can be handed over as-is
+    score = s.search(board.getBoard(), depth, white, -2000000, 2000000);
+    if (!white) score = -score;
+    lines = s.getTopMoves(board.getBoard(), depth, white, topN);
+
+    finished.store(true);
+}
+
+std::vector<ScoredMove> Ponder::finish(int& outScore, long long& nodes, double& spent) {
+    spent = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    if (worker.joinable()) worker.join();
+    active = false;
+
+    outScore = score;
+    nodes = s.getNodesSearched();
+    return lines;
+}
+
+void Ponder::cancel() {
+    if (worker.joinable()) {
+        s.stop();
+        worker.join();
+    }
+    active = false;
+}
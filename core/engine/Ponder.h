@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "../board/Board.h"
+#include "../board/Generate.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+
+// Searches the expected reply in the background while the opponent thinks.
+// Runs on a private copy of the board so the game board can change under it;
+// shares the transposition table, so even a miss leaves it warm.
+class Ponder {
+
+    Board board;
+    Generate g{board};
+    Search s;
+
+    std::thread worker;
+    std::atomic<bool> finished{false};
+    bool active = false;
+
+    Gen expected;
+    int depth = 0;
+    int topN = 1;
+
+    // Filled in by the worker
+    int score = 0;
+    std::vector<ScoredMove> lines;
+
+    std::chrono::steady_clock::time_point started;
+
+    void run();
+
+public:
+
+    explicit Ponder(TranspositionTable& tt) : s(board, g, tt) {}
+    ~Ponder() { cancel(); }
+
+    Ponder(const Ponder&) = delete;
+    Ponder& operator=(const Ponder&) = delete;
+
+    // Plays `reply` on a copy of `root` and starts searching the resulting position.
+    // Returns false if the reply is not legal there.
+    bool start(const Board& root, const Gen& reply, int depth, int topN);
+
+    void setTablebase(const Tablebase* tb) { s.setTablebase(tb); }
+
+    bool isActive() const { return active; }
+    bool isFinished() const { return finished.load(); }
+    int getDepth() const { return depth; }
+    const Gen& getExpected() const { return expected; }
+
+    bool matches(int from, int to) const {
+        return active && expected.from == from && expected.to == to;
+    }
+
+    // Ponder hit: waits for the search to complete and hands over its result.
+    // `spent` receives the seconds already searched before the hit.
+    std::vector<ScoredMove> finish(int& outScore, long long& nodes, double& spent);
+
+    // Ponder miss: abandons the search
+    void cancel();
+};
@@ -0,0 +1,141 @@
+#include "SEE.h"
+#include "../board/Piece.h"
+#include <algorithm>
+#include <cstdlib>
+
+static inline bool onBoard(int r, int c) {
+    return r >= 0 && r < 8 && c >= 0 && c < 8;
+}
+
+int SEE::value(int piece) {
+    switch (static_cast<PieceType>(std::abs(piece))) {
+        case PieceType::PAWN:   return 100;
+        case PieceType::KNIGHT: return 320;
+        case PieceType::BISHOP: return 330;
+        case PieceType::ROOK:   return 500;
+        case PieceType::QUEEN:  return 900;
+        case PieceType::KING:   return 20000;
+        default: return 0;
+    }
+}
+
+// ----------------------------------------------------------
+// Least valuable attacker of `sq` for one side
+// ----------------------------------------------------------
+int SEE::leastValuableAttacker(const std::array<int8_t, 64>& board, int sq, bool white) {
+    int r = sq / 8;
+    int c = sq % 8;
+    int sign = white ? 1 : -1;
+
+    int best = -1;
+    int bestValue = 1000000;
+
+    auto consider = [&](int idx) {
+        int v = value(board[idx]);
+        if (v < bestValue) {
+            bestValue = v;
+            best = idx;
+        }
+    };
+
+    // Pawns attack from the rank behind them
+    int pawnRow = white ? r - 1 : r + 1;
+    for (int dc : {-1, 1}) {
+        if (onBoard(pawnRow, c + dc) && board[pawnRow * 8 + c + dc] == sign * (int)PieceType::PAWN) {
+            return pawnRow * 8 + c + dc; // Nothing is cheaper
+        }
+    }
+
+    static const int kDr[] = {-2, -1, 1, 2, 2, 1, -1, -2};
+    static const int kDc[] = {1, 2, 2, 1, -1, -2, -2, -1};
+    for (int k = 0; k < 8; k++) {
+        int nr = r + kDr[k], nc = c + kDc[k];
+        if (onBoard(nr, nc) && board[nr * 8 + nc] == sign * (int)PieceType::KNIGHT) {
+            consider(nr * 8 + nc);
+        }
+    }
+
+    // Sliders: first piece on each ray
+    static const int dirs[8][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+    for (int k = 0; k < 8; k++) {
+        bool diagonal = k >= 4;
+        for (int d = 1; d < 8; d++) {
+            int nr = r + dirs[k][0] * d, nc = c + dirs[k][1] * d;
+            if (!onBoard(nr, nc)) break;
+            int p = board[nr * 8 + nc];
+            if (p == 0) continue;
+
+            if (p * sign > 0) {
+                PieceType t = static_cast<PieceType>(std::abs(p));
+                bool slides = t == PieceType::QUEEN ||
+                              (diagonal ? t == PieceType::BISHOP : t == PieceType::ROOK);
+                bool king = t == PieceType::KING && d == 1;
+                if (slides || king) consider(nr * 8 + nc);
+            }
+            break;
+        }
+    }
+
+    return best;
+}
+
+// ----------------------------------------------------------
+// Swap algorithm over a scratch board
+// ----------------------------------------------------------
+int SEE::evaluate(const std::array<int8_t, 64>& board, const Gen& move) {
+    std::array<int8_t, 64> bd = board;
+    int to = move.to;
+    bool white = move.piece > 0;
+
+    int gain[32];
+    int d = 0;
+
+    gain[0] = value(move.pieceTaken);
+    int onSquare = value(move.piece); // value of the piece that would be captured next
+
+    if (move.promotion) {
+        gain[0] += value(5) - value(1);
+        onSquare = value(5);
+    }
+
+    // En passant: the captured pawn is not on `to`
+    if (move.pieceTaken != 0 && bd[to] == 0) {
+        bd[move.from + (to % 8 - move.from % 8)] = 0;
+    }
+
+    bd[to] = static_cast<int8_t>(move.promotion ? (white ? 5 : -5) : move.piece);
+    bd[move.from] = 0;
+
+    bool side = !white;
+
+    while (d < 31) {
+        int from = leastValuableAttacker(bd, to, side);
+        if (from < 0) break;
+
+        // A king may only recapture if the square is no longer defended
+        if (std::abs(bd[from]) == (int)PieceType::KING) {
+            std::array<int8_t, 64> test = bd;
+            test[to] = test[from];
+            test[from] = 0;
+            if (leastValuableAttacker(test, to, !side) >= 0) break;
+        }
+
+        d++;
+        gain[d] = onSquare - gain[d - 1];
+
+        // Neither side can improve by continuing
+        if (std::max(-gain[d - 1], gain[d]) < 0) break;
+
+        onSquare = value(bd[from]);
+        bd[to] = bd[from];
+        bd[from] = 0;
+        side = !side;
+    }
+
+    while (d > 0) {
+        gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+        d--;
+    }
+
+    return gain[0];
+}
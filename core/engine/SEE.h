@@ -0,0 +1,26 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "../board/Generate.h"
+
+// Static Exchange Evaluation: material outcome of the capture sequence on one square,
+// both sides always recapturing with their least valuable piece and free to stop.
+// Works on a scratch copy of the board, so sliders behind a capturer (x-rays) join in.
+class SEE {
+
+    // Square of the least valuable piece of `white` attacking `sq`, -1 if none
+    static int leastValuableAttacker(const std::array<int8_t, 64>& board, int sq, bool white);
+
+public:
+
+    static int value(int piece);
+
+    // Net gain in centipawns for the side making `move`
+    static int evaluate(const std::array<int8_t, 64>& board, const Gen& move);
+
+    // True if the exchange started by `move` gains at least `threshold`
+    static bool atLeast(const std::array<int8_t, 64>& board, const Gen& move, int threshold) {
+        return evaluate(board, move) >= threshold;
+    }
+};
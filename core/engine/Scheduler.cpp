@@ -0,0 +1,53 @@
+#include "Scheduler.h"
+#include "Session.h"
+#include "Trace.h"
+#include <algorithm>
+#include <thread>
+
+static thread_local SearchWorker* currentWorker = nullptr;
+
+Scheduler::Scheduler(int threads, TranspositionTable& tt, const Tablebase* tb)
+    : tt(tt), tablebase(tb) {
+    for (int i = 0; i < std::max(threads, 1); i++) std::thread(&Scheduler::work, this).detach();
+}
+
+void Scheduler::spawn(Task task) {
+    std::coroutine_handle<Task::promise_type> h = std::exchange(task.handle, {});
+    h.promise().detached = true;
+    post(h);
+}
+
+void Scheduler::post(std::coroutine_handle<> h) {
+    std::lock_guard<std::mutex> lock(mutex);
+    runQueue.push_back(h);
+    ready.notify_one();
+}
+
+bool Scheduler::hasWaiting() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !runQueue.empty();
+}
+
+SearchWorker& Scheduler::worker() {
+    return *currentWorker;
+}
+
+// ----------------------------------------------------------
+// Pool thread: one turn of one task at a time, in queue order
+// ----------------------------------------------------------
+void Scheduler::work() {
+    SearchWorker searchWorker(tt, tablebase);
+    currentWorker = &searchWorker;
+    Trace::threadName("scheduler");
+
+    for (;;) {
+        std::coroutine_handle<> h;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [&] { return !runQueue.empty(); });
+            h = runQueue.front();
+            runQueue.pop_front();
+        }
+        h.resume();
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <utility>
+#include "TranspositionTable.h"
+#include "Tablebase.h"
+
+struct SearchWorker;
+
+// Resumable job of the Scheduler (C++20 coroutine). Starts suspended; awaiting a Task
+// runs it, across as many time slices as it needs, and then resumes the awaiter.
+class Task {
+public:
+
+    struct promise_type {
+        std::coroutine_handle<> continuation;
+        bool detached = false; // owned by the scheduler: frees itself when done
+
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        struct Final {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                std::coroutine_handle<> next = h.promise().continuation;
+                if (h.promise().detached) h.destroy();
+                return next ? next : std::noop_coroutine();
+            }
+            void await_resume() noexcept {}
+        };
+        Final final_suspend() noexcept { return {}; }
+
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+    Task& operator=(Task&&) = delete;
+    ~Task() { if (handle) handle.destroy(); }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        handle.promise().continuation = awaiter;
+        return handle;
+    }
+    void await_resume() const noexcept {}
+
+private:
+    friend class Scheduler;
+
+    std::coroutine_handle<promise_type> handle;
+    explicit Task(std::coroutine_handle<promise_type> h) : handle(h) {}
+};
+
+// Cooperative scheduler: a fixed pool of threads interleaving many Tasks.
+//
+// Each pool thread owns one SearchWorker, lent to whichever task it is running. Tasks
+// give the thread back at suspension points (co_await yield()) and rejoin the back of
+// a FIFO run queue, so every runnable task gets a turn before any task gets a second
+// one. Searches end their turns after a time SLICE when other tasks are waiting (see
+// Session::searchSliced) so a long analysis can't hold a thread while short requests wait.
+class Scheduler {
+
+    TranspositionTable& tt;
+    const Tablebase* tablebase;
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<std::coroutine_handle<>> runQueue;
+
+    void post(std::coroutine_handle<> h);
+
+    // Pool thread: resumes queued tasks one at a time
+    void work();
+
+public:
+
+    // Time a search may run in one turn; a step cut short gets up to MAX_SLICE, and
+    // cut again there, one turn without limit
+    static constexpr std::chrono::milliseconds SLICE{20};
+    static constexpr std::chrono::milliseconds MAX_SLICE{160};
+
+    Scheduler(int threads, TranspositionTable& tt, const Tablebase* tb);
+
+    // Hands a task over to the pool; it runs once a thread is free
+    void spawn(Task task);
+
+    struct Yield {
+        Scheduler& scheduler;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) { scheduler.post(h); }
+        void await_resume() const noexcept {}
+    };
+
+    // Ends the task's turn; it resumes later, possibly on another thread
+    Yield yield() { return Yield{*this}; }
+
+    // Some task is queued for a thread (a running one could hand over its thread)
+    bool hasWaiting();
+
+    // Search state of the pool thread running the calling task.
+    // Only valid until the task's next suspension point.
+    static SearchWorker& worker();
+};
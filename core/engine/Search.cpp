@@ -1,16 +1,44 @@
 #include "Search.h"
 #include "../board/Generate.h"
 #include "../board/GenerateCheck.h"
+#include "../board/Zobrist.h"
 #include "Evaluation.h"
+#include "SEE.h"
+#include "Trace.h"
 #include <limits>
 #include <optional>
 #include <algorithm>
 #include <cmath>
 #include <iostream>
 
+// Detailed search counters (SearchStats), compiled in with -DCHESS_SEARCH_STATS=ON
+#ifdef SEARCH_STATS
+#define COUNT(counter) (stats.counter++)
+#else
+#define COUNT(counter) ((void)0)
+#endif
+
 static const int CHECKMATE_SCORE = 100000;
 static const int INF = 2000000;
 
+// Mate scores are stored relative to the node, not the root
+static const int MATE_BOUND = CHECKMATE_SCORE - 1000;
+
+// Tablebase win without a known mate distance: below every mate score, above any evaluation
+static const int TB_WIN_SCORE = MATE_BOUND - MAX_PLY - 1;
+
+static int scoreToTT(int score, int ply) {
+    if (score >= MATE_BOUND) return score + ply;
+    if (score <= -MATE_BOUND) return score - ply;
+    return score;
+}
+
+static int scoreFromTT(int score, int ply) {
+    if (score >= MATE_BOUND) return score - ply;
+    if (score <= -MATE_BOUND) return score + ply;
+    return score;
+}
+
 // ----------------------------------------------------------
 // Piece value for MVV-LVA ordering
 // ----------------------------------------------------------
@@ -30,51 +58,275 @@ static int pieceOrderValue(int piece) {
 // Killer move tracking
 // ----------------------------------------------------------
 void Search::storeKiller(int ply, const Gen& move) {
-    if (ply >= MAX_DEPTH) return;
+    if (ply >= MAX_PLY) return;
     // Don't store captures as killers
     if (move.pieceTaken != 0) return;
+    Gen* killers = stack[ply].killers;
     // Shift: slot 1 = old slot 0, slot 0 = new killer
-    if (killers[ply][0].from != move.from || killers[ply][0].to != move.to) {
-        killers[ply][1] = killers[ply][0];
-        killers[ply][0] = move;
+    if (killers[0].from != move.from || killers[0].to != move.to) {
+        killers[1] = killers[0];
+        killers[0] = move;
     }
 }
 
 bool Search::isKiller(int ply, const Gen& move) const {
-    if (ply >= MAX_DEPTH) return false;
-    return (killers[ply][0].from == move.from && killers[ply][0].to == move.to) ||
-           (killers[ply][1].from == move.from && killers[ply][1].to == move.to);
+    if (ply >= MAX_PLY) return false;
+    const Gen* killers = stack[ply].killers;
+    return (killers[0].from == move.from && killers[0].to == move.to) ||
+           (killers[1].from == move.from && killers[1].to == move.to);
 }
 
 // ----------------------------------------------------------
-// Move ordering: captures (MVV-LVA) > killers > history
+// History tables: counter moves, continuation and capture history
 // ----------------------------------------------------------
-void Search::orderMoves(std::vector<Gen>& moves, int ply, bool white) {
+
+// White pieces 1..6 -> 0..5, black pieces -1..-6 -> 6..11
+static int pieceIndex(int piece) {
+    return piece > 0 ? piece - 1 : 5 - piece;
+}
+
+static int historyBonus(int depth) {
+    return std::min(16 * depth * depth + 32 * depth, 1600);
+}
+
+// Gravity update: moves the entry towards +/-HISTORY_MAX, slower the closer it already is,
+// so old results fade and scores never overflow
+static void applyHistory(int& entry, int bonus) {
+    entry += bonus - entry * std::abs(bonus) / HISTORY_MAX;
+}
+
+static bool isQuiet(const Gen& move) {
+    return move.pieceTaken == 0 && !move.promotion;
+}
+
+int* Search::counterEntry(int ply, const Gen& move) const {
+    if (ply < 1) return nullptr;
+    const Gen& prev = stack[ply - 1].currentMove;
+    if (prev.piece == 0) return nullptr; // root or null move
+    return &counterHistory[pieceIndex(prev.piece)][prev.to][pieceIndex(move.piece)][move.to];
+}
+
+int* Search::followupEntry(int ply, const Gen& move) const {
+    if (ply < 2) return nullptr;
+    const Gen& prev = stack[ply - 2].currentMove;
+    if (prev.piece == 0) return nullptr;
+    return &followupHistory[pieceIndex(prev.piece)][prev.to][pieceIndex(move.piece)][move.to];
+}
+
+int Search::quietScore(int ply, bool white, const Gen& move) const {
+    int score = history[white ? 0 : 1][move.from][move.to];
+    if (int* e = counterEntry(ply, move)) score += *e;
+    if (int* e = followupEntry(ply, move)) score += *e;
+    return score;
+}
+
+void Search::updateHistories(int ply, bool white, int depth, const Gen& best) {
+    int bonus = historyBonus(depth);
     int side = white ? 0 : 1;
+    SearchStackEntry& ss = stack[ply];
 
-    std::sort(moves.begin(), moves.end(), [&](const Gen& a, const Gen& b) {
-        // Score each move for ordering
-        auto score = [&](const Gen& m) -> int {
-            if (m.pieceTaken != 0) {
-                // MVV-LVA: victim value * 10 - attacker value
-                // Ensures captures are always first, sorted by best capture
-                return 10000000 + pieceOrderValue(m.pieceTaken) * 10 - pieceOrderValue(m.piece);
-            }
-            if (isKiller(ply, m)) {
-                return 5000000; // Below captures, above quiet moves
-            }
-            // History heuristic for quiet moves
-            return history[side][m.from][m.to];
-        };
-        return score(a) > score(b);
+    if (isQuiet(best)) {
+        applyHistory(history[side][best.from][best.to], bonus);
+        if (int* e = counterEntry(ply, best)) applyHistory(*e, bonus);
+        if (int* e = followupEntry(ply, best)) applyHistory(*e, bonus);
+
+        if (ply > 0 && stack[ply - 1].currentMove.piece != 0) {
+            const Gen& prev = stack[ply - 1].currentMove;
+            counterMoves[pieceIndex(prev.piece)][prev.to] = best;
+        }
+
+        // Quiets searched before the cutoff move failed to produce one
+        for (const Gen& q : ss.quietsTried) {
+            applyHistory(history[side][q.from][q.to], -bonus);
+            if (int* e = counterEntry(ply, q)) applyHistory(*e, -bonus);
+            if (int* e = followupEntry(ply, q)) applyHistory(*e, -bonus);
+        }
+    } else if (best.pieceTaken != 0) {
+        applyHistory(captureHistory[pieceIndex(best.piece)][best.to][std::abs(best.pieceTaken) - 1], bonus);
+    }
+
+    for (const Gen& c : ss.capturesTried) {
+        applyHistory(captureHistory[pieceIndex(c.piece)][c.to][std::abs(c.pieceTaken) - 1], -bonus);
+    }
+}
+
+// ----------------------------------------------------------
+// Repetition and fifty-move detection
+// ----------------------------------------------------------
+void Search::prepareRoot(const std::array<int8_t, 64>& board, bool white) {
+    castleKey = hashCastling(b);
+
+    auto usable = [&](bool side, bool kingSide) {
+        int king = side ? 4 : 60;
+        int rook = kingSide ? king + 3 : king - 4;
+        bool right = kingSide ? b.canCastleKingSide(side) : b.canCastleQueenSide(side);
+        return right && board[king] == (side ? 6 : -6) && board[rook] == (side ? 2 : -2);
+    };
+    rootCastling = usable(true, true) || usable(true, false) || usable(false, true) || usable(false, false);
+
+    positionKeys = b.getKeyHistory();
+    uint64_t rootKey = hashBoard(board, white) ^ castleKey;
+    // Searching a position that isn't the game's current one: no usable history
+    if (positionKeys.empty() || positionKeys.back() != rootKey) {
+        positionKeys.assign(1, rootKey);
+        stack[0].rule50 = 0;
+    } else {
+        stack[0].rule50 = b.getHalfmoveClock();
+    }
+    gameLength = (int)positionKeys.size();
+    positionKeys.resize(gameLength + MAX_PLY);
+}
+
+bool Search::isRepetition(int ply, uint64_t key) const {
+    int last = gameLength - 1 + ply;
+    // Same side to move, at least 4 plies back, none of them irreversible
+    for (int i = 4; i <= stack[ply].rule50 && last - i >= 0; i += 2) {
+        if (positionKeys[last - i] == key) return true;
+    }
+    return false;
+}
+
+// ----------------------------------------------------------
+// Tablebase root: exact mate distances for every move
+// ----------------------------------------------------------
+bool Search::probeRoot(const std::array<int8_t, 64>& board, bool white, std::vector<ScoredMove>& out) {
+    if (!tablebase || rootCastling || Tablebase::countMen(board) > tablebase->maxPieces()) return false;
+
+    std::vector<Gen>& moves = stack[0].moves;
+    g.generate(board, white, moves);
+    out.clear();
+
+    for (Gen& move : moves) {
+        std::optional<std::array<int8_t, 64>> nextBoard = g.makeMove(board, white, move);
+        if (!nextBoard.has_value()) continue;
+
+        // Result for the opponent, who moves next
+        int result, plies;
+        if (!tablebase->probeDTM(nextBoard.value(), !white, result, plies)) return false;
+
+        int score = 0;
+        if (result < 0) score = CHECKMATE_SCORE - (plies + 1);
+        else if (result > 0) score = -(CHECKMATE_SCORE - (plies + 1));
+
+        out.push_back({{move}, white ? score : -score});
+    }
+
+    std::stable_sort(out.begin(), out.end(), [&](const ScoredMove& a, const ScoredMove& b) {
+        return white ? a.score > b.score : a.score < b.score;
     });
+    return !out.empty();
+}
+
+// ----------------------------------------------------------
+// Triangular PV: this ply's line = move + line of the child
+// ----------------------------------------------------------
+void Search::updatePV(int ply, const Gen& move) {
+    pvTable[ply][0] = move;
+    int childLen = pvLength[ply + 1];
+    for (int i = 0; i < childLen; i++) {
+        pvTable[ply][i + 1] = pvTable[ply + 1][i];
+    }
+    pvLength[ply] = childLen + 1;
 }
 
 // ----------------------------------------------------------
-// Quiescence search: keep searching captures until quiet
+// Move ordering: TT move > winning/equal captures (MVV-LVA + capture history) > killers
+//                > counter move > losing captures (SEE < 0) > quiet histories
 // ----------------------------------------------------------
-int Search::quiesce(std::array<int8_t, 64> board, bool white, int alpha, int beta, Evaluation& eval) {
-    nodesSearched++;
+static const int ORDER_TT = 20000000;
+static const int ORDER_GOOD_CAPTURE = 10000000;
+static const int ORDER_KILLER = 5000000;
+static const int ORDER_COUNTER = 4500000;
+static const int ORDER_BAD_CAPTURE = 4000000;
+
+// Lowest score of a winning or equal capture. MVV-LVA (a king taking a pawn is -19000) and
+// capture history (-HISTORY_MAX / 8) lower a capture within its band, never below this,
+// and a losing capture never reaches it.
+static const int ORDER_GOOD_CAPTURE_MIN = (ORDER_GOOD_CAPTURE + ORDER_KILLER) / 2;
+
+void Search::orderMoves(std::vector<Gen>& moves, const std::array<int8_t, 64>& board, int ply, bool white, int ttFrom, int ttTo) {
+    std::vector<int>& scores = stack[ply].scores;
+    scores.resize(moves.size());
+
+    // Quiet reply that refuted the previous move last time
+    const Gen* counter = nullptr;
+    if (ply > 0 && stack[ply - 1].currentMove.piece != 0) {
+        const Gen& prev = stack[ply - 1].currentMove;
+        counter = &counterMoves[pieceIndex(prev.piece)][prev.to];
+    }
+
+    // Score each move once
+    for (size_t i = 0; i < moves.size(); i++) {
+        const Gen& m = moves[i];
+        int score;
+
+        if (m.from == ttFrom && m.to == ttTo) {
+            score = ORDER_TT; // Best move from a previous search of this position
+        } else if (m.pieceTaken != 0 || m.promotion) {
+            // MVV-LVA: victim value * 10 - attacker value, promotions count the new queen
+            int mvvLva = pieceOrderValue(m.pieceTaken) * 10 - pieceOrderValue(m.piece);
+            if (m.promotion) mvvLva += pieceOrderValue(5) * 10;
+            if (m.pieceTaken != 0) mvvLva += captureHistory[pieceIndex(m.piece)][m.to][std::abs(m.pieceTaken) - 1] / 8;
+            // Taking something at least as valuable can't lose material; otherwise ask SEE
+            bool good = (m.pieceTaken != 0 && pieceOrderValue(m.pieceTaken) >= pieceOrderValue(m.piece)) ||
+                        SEE::evaluate(board, m) >= 0;
+            score = (good ? ORDER_GOOD_CAPTURE : ORDER_BAD_CAPTURE) + mvvLva;
+        } else if (isKiller(ply, m)) {
+            score = ORDER_KILLER; // Below good captures, above quiet moves
+        } else if (counter && counter->piece == m.piece && counter->from == m.from && counter->to == m.to) {
+            score = ORDER_COUNTER;
+        } else {
+            // Butterfly + continuation histories for quiet moves
+            score = quietScore(ply, white, m);
+        }
+
+        scores[i] = score;
+    }
+
+    // Insertion sort, best first (lists are short)
+    for (size_t i = 1; i < moves.size(); i++) {
+        Gen m = moves[i];
+        int sc = scores[i];
+        size_t j = i;
+        while (j > 0 && scores[j - 1] < sc) {
+            moves[j] = moves[j - 1];
+            scores[j] = scores[j - 1];
+            j--;
+        }
+        moves[j] = m;
+        scores[j] = sc;
+    }
+}
+
+// ----------------------------------------------------------
+// Limits: node budget and deadline
+// ----------------------------------------------------------
+void Search::checkLimits() {
+    nodesPublished.store(nodesSearched, std::memory_order_relaxed);
+
+    if (nodeLimit > 0 && nodesSearched >= nodeLimit) stop();
+
+    int64_t end = deadline.load(std::memory_order_relaxed);
+    if (end != 0 && std::chrono::steady_clock::now().time_since_epoch().count() >= end) {
+        if (!onDeadline || !onDeadline()) stop();
+    }
+}
+
+int Search::mateDistance(int score) {
+    if (score >= MATE_BOUND) return (CHECKMATE_SCORE - score + 1) / 2;
+    if (score <= -MATE_BOUND) return -(CHECKMATE_SCORE + score) / 2;
+    return 0;
+}
+
+// ----------------------------------------------------------
+// Quiescence search: keep searching captures and promotions until quiet
+// ----------------------------------------------------------
+int Search::quiesce(std::array<int8_t, 64> board, int ply, bool white, int alpha, int beta, Evaluation& eval) {
+    if (isStopped()) return 0;
+    if ((++nodesSearched & 1023) == 0) checkLimits();
+    selDepth = std::max(selDepth, ply);
+    COUNT(qsearchNodes);
+    COUNT(evaluations);
 
     int standPat = eval.evaluation(board);
     standPat = white ? standPat : -standPat;
@@ -85,19 +337,25 @@ int Search::quiesce(std::array<int8_t, 64> board, bool white, int alpha, int bet
     // Delta pruning: if even capturing a queen can't raise alpha, skip
     if (standPat + 1000 < alpha) return alpha;
 
-    std::vector<Gen> moves = g.generate(board, white);
-    orderMoves(moves, 0, white);
+    // Out of stack: treat as quiet
+    if (ply >= MAX_PLY - 1) return alpha;
+
+    // Only captures and promotions are generated
+    std::vector<Gen>& moves = stack[ply].moves;
+    g.generateTactical(board, white, moves);
+    orderMoves(moves, board, ply, white);
+    const std::vector<int>& scores = stack[ply].scores;
 
-    for (auto& move : moves) {
-        if (move.pieceTaken == 0) continue; // Only captures
+    for (size_t i = 0; i < moves.size(); i++) {
+        Gen& move = moves[i];
 
-        // SEE-like pruning: skip captures of higher value pieces by lower value ones
-        // (don't search pawn captures queen if we're way behind)
+        // Losing captures are ordered last: everything from here on loses material
+        if (scores[i] < ORDER_GOOD_CAPTURE_MIN) break;
 
         std::optional<std::array<int8_t, 64>> nextBoard = g.makeMove(board, white, move);
         if (!nextBoard.has_value()) continue;
 
-        int score = -quiesce(nextBoard.value(), !white, -beta, -alpha, eval);
+        int score = -quiesce(nextBoard.value(), ply + 1, !white, -beta, -alpha, eval);
 
         if (score >= beta) return beta;
         if (score > alpha) alpha = score;
@@ -109,29 +367,82 @@ int Search::quiesce(std::array<int8_t, 64> board, bool white, int alpha, int bet
 // ----------------------------------------------------------
 // Core alpha-beta with all pruning techniques
 // ----------------------------------------------------------
-int Search::alphabeta(std::array<int8_t, 64> board, int depth, int ply, bool white, int alpha, int beta, std::vector<Gen>* pv, Evaluation& eval) {
-    if (pv) pv->clear();
+int Search::alphabeta(std::array<int8_t, 64> board, int depth, int ply, bool white, int alpha, int beta, bool pvNode, Evaluation& eval) {
+    pvLength[ply] = 0;
+
+    // Fifty-move counter: reset by captures, pawn moves and null moves (which break repetition chains)
+    uint64_t key = 0;
+    if (ply > 0) {
+        const Gen& prev = stack[ply - 1].currentMove;
+        bool irreversible = prev.piece == 0 || prev.pieceTaken != 0 || std::abs(prev.piece) == 1;
+        stack[ply].rule50 = irreversible ? 0 : stack[ply - 1].rule50 + 1;
+
+        // Draw by fifty-move rule or repetition: no need to search the cycle again
+        if (stack[ply].rule50 >= 100) return 0;
+        if (stack[ply].rule50 >= 4) {
+            key = hashBoard(board, white) ^ castleKey;
+            if (isRepetition(ply, key)) return 0;
+        }
+    }
 
-    // Leaf node: quiescence search
-    if (depth <= 0) {
-        return quiesce(board, white, alpha, beta, eval);
+    // Leaf node (or out of stack): quiescence search
+    if (depth <= 0 || ply >= MAX_PLY - 1) {
+        return quiesce(board, ply, white, alpha, beta, eval);
     }
 
-    nodesSearched++;
+    if (isStopped()) return 0;
+    if ((++nodesSearched & 1023) == 0) checkLimits();
+    selDepth = std::max(selDepth, ply);
+
+    // Tablebase: the game-theoretic result replaces the search below this node
+    if (tablebase && ply > 0 && !rootCastling && Tablebase::countMen(board) <= tablebase->maxPieces()) {
+        int wdl;
+        if (tablebase->probeWDL(board, white, wdl)) {
+            if (wdl > 0) return TB_WIN_SCORE - ply;
+            if (wdl < 0) return -TB_WIN_SCORE + ply;
+            return 0;
+        }
+    }
 
     GenerateCheck gc;
     bool inCheck = gc.isCheck(board, white);
 
     // Check extension: extend search by 1 ply when in check
-    if (inCheck) depth++;
+    if (inCheck) {
+        depth++;
+        COUNT(checkExtensions);
+    }
+
+    if (key == 0) key = hashBoard(board, white) ^ castleKey;
+    positionKeys[gameLength - 1 + ply] = key;
+
+    // Transposition table: cut off on a deep enough bound, otherwise use its move for ordering
+    TTEntry tte;
+    bool ttHit = tt.probe(key, tte);
+    COUNT(ttProbes);
+    if (ttHit) COUNT(ttHits);
+
+    if (ttHit && !pvNode && ply > 0 && tte.depth >= depth) {
+        int ttScore = scoreFromTT(tte.score, ply);
+        if (tte.flag == TTFlag::EXACT || (tte.flag == TTFlag::LOWER && ttScore >= beta) ||
+            (tte.flag == TTFlag::UPPER && ttScore <= alpha)) {
+            COUNT(ttCutoffs);
+        }
+        if (tte.flag == TTFlag::EXACT) return ttScore;
+        if (tte.flag == TTFlag::LOWER && ttScore >= beta) return beta;
+        if (tte.flag == TTFlag::UPPER && ttScore <= alpha) return alpha;
+    }
 
     // Reverse Futility Pruning
     if (!inCheck && depth <= 3 && ply > 0) {
         int evalScore = eval.evaluation(board);
+        COUNT(evaluations);
         evalScore = white ? evalScore : -evalScore;
+        stack[ply].staticEval = evalScore;
         
         int margin = 120 * depth;
         if (evalScore - margin >= beta) {
+            COUNT(rfpPrunes);
             return evalScore - margin; 
         }
     }
@@ -139,59 +450,93 @@ int Search::alphabeta(std::array<int8_t, 64> board, int depth, int ply, bool whi
     // Null move pruning: skip our turn (only if not in check, has pieces)
     if (!inCheck && depth >= 3 && ply > 0) {
         // Search with reduced depth after passing
-        int nullScore = -alphabeta(board, depth - 3, ply + 1, !white, -beta, -beta + 1, nullptr, eval);
-        if (nullScore >= beta) return beta;
+        stack[ply].currentMove = Gen{};
+        COUNT(nullMoveTries);
+        int nullScore = -alphabeta(board, depth - 3, ply + 1, !white, -beta, -beta + 1, false, eval);
+        if (nullScore >= beta) {
+            COUNT(nullMovePrunes);
+            return beta;
+        }
     }
 
-    std::vector<Gen> moves = g.generate(board, white);
-    orderMoves(moves, ply, white);
+    std::vector<Gen>& moves = stack[ply].moves;
+    g.generate(board, white, moves);
+    orderMoves(moves, board, ply, white, ttHit ? tte.from : -1, ttHit ? tte.to : -1);
+    const std::vector<int>& scores = stack[ply].scores;
 
     int bestScore = -INF;
     bool hasLegalMove = false;
     int movesSearched = 0;
+    int origAlpha = alpha;
+    Gen bestMove;
+    stack[ply].quietsTried.clear();
+    stack[ply].capturesTried.clear();
 
-    for (auto& move : moves) {
+    for (size_t i = 0; i < moves.size(); i++) {
+        Gen& move = moves[i];
         std::optional<std::array<int8_t, 64>> nextBoard = g.makeMove(board, white, move);
         if (!nextBoard.has_value()) continue;
 
         hasLegalMove = true;
+
+        // SEE pruning: near the leaves, skip captures that lose clearly more than the depth allows
+        if (movesSearched > 0 && !inCheck && depth <= 3 && move.pieceTaken != 0 &&
+            scores[i] < ORDER_GOOD_CAPTURE_MIN && SEE::evaluate(board, move) < -100 * depth) {
+            continue;
+        }
+
         movesSearched++;
 
         int score;
-        std::vector<Gen> childPV;
+        stack[ply].currentMove = move;
+        int64_t rootStarted = ply == 0 && Trace::enabled() ? Trace::now() : -1;
+
+        if (movesSearched == 1) {
+            // First move: full window, it is expected to be the best
+            score = -alphabeta(nextBoard.value(), depth - 1, ply + 1, !white, -beta, -alpha, pvNode, eval);
+        } else {
+            // Principal variation search: prove the move is no better with a zero window
+            if (movesSearched > 3 && depth >= 3 && !inCheck && move.pieceTaken == 0) {
+                // Late move reductions (LMR): reduced-depth scout for late quiet moves
+                COUNT(lmrReductions);
+                score = -alphabeta(nextBoard.value(), depth - 2, ply + 1, !white, -alpha - 1, -alpha, false, eval);
+                if (score > alpha) COUNT(lmrResearches);
+            } else {
+                score = alpha + 1; // Force the full-depth scout
+            }
 
-        // Late move reductions (LMR): reduce depth for late quiet moves
-        if (movesSearched > 3 && depth >= 3 && !inCheck && move.pieceTaken == 0) {
-            // Reduced search
-            score = -alphabeta(nextBoard.value(), depth - 2, ply + 1, !white, -alpha - 1, -alpha, nullptr, eval);
-            // If it improves alpha, re-search at full depth
             if (score > alpha) {
-                score = -alphabeta(nextBoard.value(), depth - 1, ply + 1, !white, -beta, -alpha, pv ? &childPV : nullptr, eval);
+                score = -alphabeta(nextBoard.value(), depth - 1, ply + 1, !white, -alpha - 1, -alpha, false, eval);
+            }
+
+            // Scout failed high inside the window: re-search with the full window
+            if (score > alpha && score < beta) {
+                score = -alphabeta(nextBoard.value(), depth - 1, ply + 1, !white, -beta, -alpha, pvNode, eval);
             }
-        } else {
-            score = -alphabeta(nextBoard.value(), depth - 1, ply + 1, !white, -beta, -alpha, pv ? &childPV : nullptr, eval);
         }
 
+        if (rootStarted >= 0) Trace::complete("root move", "search", rootStarted, "depth", depth, &move);
+        if (isStopped()) return 0;
+
         if (score > bestScore) bestScore = score;
 
         if (score >= beta) {
             // Beta cutoff
+            betaCutoffs++;
+            if (movesSearched == 1) firstMoveCutoffs++;
             storeKiller(ply, move);
-            // Update history for quiet moves
-            if (move.pieceTaken == 0) {
-                int side = white ? 0 : 1;
-                history[side][move.from][move.to] += depth * depth;
-            }
+            updateHistories(ply, white, depth, move);
+            tt.store(key, depth, scoreToTT(beta, ply), TTFlag::LOWER, move.from, move.to);
             return beta;
         }
 
+        if (isQuiet(move)) stack[ply].quietsTried.push_back(move);
+        else if (move.pieceTaken != 0) stack[ply].capturesTried.push_back(move);
+
         if (score > alpha) {
             alpha = score;
-            if (pv) {
-                pv->clear();
-                pv->push_back(move);
-                pv->insert(pv->end(), childPV.begin(), childPV.end());
-            }
+            bestMove = move;
+            if (pvNode) updatePV(ply, move);
         }
     }
 
@@ -202,20 +547,70 @@ int Search::alphabeta(std::array<int8_t, 64> board, int depth, int ply, bool whi
         return 0; // Stalemate
     }
 
+    if (alpha > origAlpha) {
+        tt.store(key, depth, scoreToTT(alpha, ply), TTFlag::EXACT, bestMove.from, bestMove.to);
+    } else {
+        tt.store(key, depth, scoreToTT(alpha, ply), TTFlag::UPPER, -1, -1);
+    }
+
     return alpha;
 }
 
+// ----------------------------------------------------------
+// Root search with an aspiration window around the previous score
+// ----------------------------------------------------------
+int Search::aspiration(std::array<int8_t, 64>& board, int depth, bool white, int prevScore, bool pvNode, Evaluation& eval) {
+    // Shallow iterations are cheap and their scores unstable: use a full window
+    if (depth < 4) {
+        return alphabeta(board, depth, 0, white, -INF, INF, pvNode, eval);
+    }
+
+    int window = 40;
+    int alpha = std::max(prevScore - window, -INF);
+    int beta = std::min(prevScore + window, INF);
+
+    for (;;) {
+        int score = alphabeta(board, depth, 0, white, alpha, beta, pvNode, eval);
+        if (isStopped()) return score;
+
+        // Widen only the side that failed, doubling each time
+        if (score <= alpha) {
+            window *= 2;
+            alpha = std::max(score - window, -INF);
+        } else if (score >= beta) {
+            window *= 2;
+            beta = std::min(score + window, INF);
+        } else {
+            return score;
+        }
+
+        if (window > 1000) {
+            alpha = -INF;
+            beta = INF;
+        }
+    }
+}
+
 // ----------------------------------------------------------
 // Iterative deepening wrapper
 // ----------------------------------------------------------
 int Search::search(std::array<int8_t, 64> board, int depth, bool white, int alpha, int beta) {
-    nodesSearched = 0;
+    resetStats();
+    prepareRoot(board, white);
     int score = 0;
     Evaluation eval;
 
+    std::vector<ScoredMove> tbMoves;
+    if (probeRoot(board, white, tbMoves)) return white ? tbMoves[0].score : -tbMoves[0].score;
+
     // Iterative deepening: search depth 1, 2, ... up to target
     for (int d = 1; d <= depth; d++) {
-        score = alphabeta(board, d, 0, white, -INF, INF, nullptr, eval);
+        auto iterStart = std::chrono::steady_clock::now();
+        TraceSpan span("iteration", "search", "depth", d);
+        int iterScore = aspiration(board, d, white, score, false, eval);
+        if (isStopped()) break; // Keep the last completed iteration
+        score = iterScore;
+        recordIteration(iterStart);
     }
 
     return score;
@@ -225,55 +620,170 @@ int Search::search(std::array<int8_t, 64> board, int depth, bool white, int alph
 // PV search for display
 // ----------------------------------------------------------
 int Search::searchPV(std::array<int8_t, 64> board, int depth, bool white, int alpha, int beta, std::vector<Gen>& pv) {
-    nodesSearched = 0;
+    resetStats();
+    prepareRoot(board, white);
     int score = 0;
     Evaluation eval;
 
+    std::vector<ScoredMove> tbMoves;
+    if (probeRoot(board, white, tbMoves)) {
+        pv = tbMoves[0].line;
+        return white ? tbMoves[0].score : -tbMoves[0].score;
+    }
+
     // With iterative deepening, each iteration informs move ordering
     for (int d = 1; d <= depth; d++) {
-        std::vector<Gen> iterPV;
-        score = alphabeta(board, d, 0, white, -INF, INF, &iterPV, eval);
-        if (d == depth) pv = iterPV; // Keep the last iteration's PV
+        auto iterStart = std::chrono::steady_clock::now();
+        TraceSpan span("iteration", "search", "depth", d);
+        int iterScore = aspiration(board, d, white, score, true, eval);
+        if (isStopped()) break; // Keep the last completed iteration
+        score = iterScore;
+        recordIteration(iterStart);
+        pv.assign(pvTable[0], pvTable[0] + pvLength[0]);
+        if (onIteration && !onIteration(d, score, pv)) break;
+    }
+
+    return score;
+}
+
+int Search::searchIteration(std::array<int8_t, 64> board, int depth, bool white, int prevScore, std::vector<Gen>& pv) {
+    resetStats();
+    prepareRoot(board, white);
+    Evaluation eval;
+
+    std::vector<ScoredMove> tbMoves;
+    if (probeRoot(board, white, tbMoves)) {
+        pv = tbMoves[0].line;
+        return white ? tbMoves[0].score : -tbMoves[0].score;
     }
 
+    auto iterStart = std::chrono::steady_clock::now();
+    TraceSpan span("iteration", "search", "depth", depth);
+    int score = aspiration(board, depth, white, prevScore, true, eval);
+    if (!isStopped()) {
+        pv.assign(pvTable[0], pvTable[0] + pvLength[0]);
+        recordIteration(iterStart);
+    }
     return score;
 }
 
+void Search::recordIteration(std::chrono::steady_clock::time_point started) {
+    stats.iterationMs.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count());
+}
+
+SearchStats Search::getStats() const {
+    SearchStats s = stats;
+#ifdef SEARCH_STATS
+    s.detailed = true;
+#endif
+    s.nodes = nodesSearched;
+    s.betaCutoffs = betaCutoffs;
+    s.firstMoveCutoffs = firstMoveCutoffs;
+    s.selDepth = selDepth;
+    return s;
+}
+
+void SearchStats::add(const SearchStats& other) {
+    detailed = detailed || other.detailed;
+    nodes += other.nodes;
+    qsearchNodes += other.qsearchNodes;
+    betaCutoffs += other.betaCutoffs;
+    firstMoveCutoffs += other.firstMoveCutoffs;
+    selDepth = std::max(selDepth, other.selDepth);
+    nullMoveTries += other.nullMoveTries;
+    nullMovePrunes += other.nullMovePrunes;
+    rfpPrunes += other.rfpPrunes;
+    lmrReductions += other.lmrReductions;
+    lmrResearches += other.lmrResearches;
+    checkExtensions += other.checkExtensions;
+    ttProbes += other.ttProbes;
+    ttHits += other.ttHits;
+    ttCutoffs += other.ttCutoffs;
+    evaluations += other.evaluations;
+    iterationMs.insert(iterationMs.end(), other.iterationMs.begin(), other.iterationMs.end());
+}
+
 // ----------------------------------------------------------
 // Top N moves for display
 // ----------------------------------------------------------
 std::vector<ScoredMove> Search::getTopMoves(std::array<int8_t, 64> board, int depth, bool white, int topN) {
-    std::vector<ScoredMove> results;
-    std::vector<Gen> moves = g.generate(board, white);
-    orderMoves(moves, 0, white);
+    TopMovesProgress progress;
+    return getTopMoves(board, depth, white, topN, progress);
+}
+
+std::vector<ScoredMove> Search::getTopMoves(std::array<int8_t, 64> board, int depth, bool white, int topN,
+                                            TopMovesProgress& progress) {
+    std::vector<ScoredMove>& results = progress.results;
+    TraceSpan span("getTopMoves", "search", "depth", depth);
+    prepareRoot(board, white);
+
+    std::vector<ScoredMove> tbMoves;
+    if (probeRoot(board, white, tbMoves)) {
+        if ((int)tbMoves.size() > topN) tbMoves.resize(topN);
+        results = tbMoves;
+        return results;
+    }
+
+    // The root moves are ordered once, so a resumed call continues the same sequence.
+    // The previous search of this position (e.g. search() just before) supplies the first move.
+    std::vector<Gen>& moves = progress.moves;
+    if (progress.next == 0) {
+        TTEntry rootEntry;
+        bool rootHit = tt.probe(positionKeys[gameLength - 1], rootEntry);
+
+        g.generate(board, white, stack[0].moves);
+        orderMoves(stack[0].moves, board, 0, white, rootHit ? rootEntry.from : -1, rootHit ? rootEntry.to : -1);
+        moves = stack[0].moves;
+        results.clear();
+    }
     Evaluation eval;
 
-    for (auto& move : moves) {
+    auto better = [&](const ScoredMove& a, const ScoredMove& b) {
+        if (white) return a.score > b.score;
+        else return a.score < b.score;
+    };
+
+    for (; progress.next < moves.size(); progress.next++) {
+        Gen& move = moves[progress.next];
         std::optional<std::array<int8_t, 64>> nextBoard = g.makeMove(board, white, move);
         if (!nextBoard.has_value()) continue;
 
-        std::vector<Gen> childPV;
+        stack[0].currentMove = move;
+        int64_t rootStarted = Trace::enabled() ? Trace::now() : -1;
+
         // Search directly at (depth - 1)
         int searchDepth = depth - 1 < 1 ? 1 : depth - 1;
-        int score = -alphabeta(nextBoard.value(), searchDepth, 1, !white, -INF, INF, &childPV, eval);
+
+        // Once N lines are known, a move only needs an exact score if it beats the N-th:
+        // prove it doesn't with a zero-window scout
+        if ((int)results.size() >= topN) {
+            int threshold = white ? results[topN - 1].score : -results[topN - 1].score;
+            int scout = -alphabeta(nextBoard.value(), searchDepth, 1, !white, -threshold - 1, -threshold, false, eval);
+            if (isStopped()) break;
+            if (scout <= threshold) {
+                if (rootStarted >= 0) Trace::complete("root move", "topmoves", rootStarted, "depth", searchDepth, &move);
+                continue;
+            }
+        }
+
+        int score = -alphabeta(nextBoard.value(), searchDepth, 1, !white, -INF, INF, true, eval);
+        if (rootStarted >= 0) Trace::complete("root move", "topmoves", rootStarted, "depth", searchDepth, &move);
+        if (isStopped()) break;
 
         int absScore = white ? score : -score;
 
         ScoredMove sm;
         sm.score = absScore;
+        sm.line.reserve(pvLength[1] + 1);
         sm.line.push_back(move);
-        sm.line.insert(sm.line.end(), childPV.begin(), childPV.end());
+        sm.line.insert(sm.line.end(), pvTable[1], pvTable[1] + pvLength[1]);
 
-        results.push_back(sm);
-    }
+        results.insert(std::upper_bound(results.begin(), results.end(), sm, better), std::move(sm));
 
-    std::sort(results.begin(), results.end(), [&](const ScoredMove& a, const ScoredMove& b) {
-        if (white) return a.score > b.score;
-        else return a.score < b.score;
-    });
-
-    if ((int)results.size() > topN) {
-        results.resize(topN);
+        if ((int)results.size() > topN) {
+            results.resize(topN);
+        }
     }
 
     return results;
@@ -5,40 +5,179 @@
 #include <vector>
 #include <string>
 #include <chrono>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <functional>
 #include "../board/Board.h"
 #include "../board/Generate.h"
 #include "../engine/Evaluation.h"
+#include "../engine/TranspositionTable.h"
+#include "../engine/Tablebase.h"
 
 struct ScoredMove {
     std::vector<Gen> line;
     int score;
 };
 
-// Killer moves: non-capture moves that caused beta cutoffs
-static const int MAX_DEPTH = 64;
+// Where a search spent its effort. Nodes, cutoffs, seldepth and iteration times are
+// always kept; the other counters only in builds configured with CHESS_SEARCH_STATS
+// (SEARCH_STATS defined), and read 0 otherwise, with `detailed` false.
+struct SearchStats {
+    bool detailed = false;
+    long long nodes = 0;            // main search + quiescence
+    long long qsearchNodes = 0;
+    long long betaCutoffs = 0;
+    long long firstMoveCutoffs = 0;
+    int selDepth = 0;
+    long long nullMoveTries = 0;
+    long long nullMovePrunes = 0;
+    long long rfpPrunes = 0;        // reverse futility pruning
+    long long lmrReductions = 0;
+    long long lmrResearches = 0;    // reduced scouts that failed high
+    long long checkExtensions = 0;
+    long long ttProbes = 0;
+    long long ttHits = 0;
+    long long ttCutoffs = 0;
+    long long evaluations = 0;      // static evaluations (there is no evaluation cache)
+    std::vector<long long> iterationMs; // per completed iteration
+
+    double firstMoveCutoffRate() const { return betaCutoffs > 0 ? (double)firstMoveCutoffs / betaCutoffs : 0.0; }
+    double ttHitRate() const { return ttProbes > 0 ? (double)ttHits / ttProbes : 0.0; }
+
+    // Adds another search's counts (searches run in several parts)
+    void add(const SearchStats& other);
+};
+
+// Root moves getTopMoves() has finished so far, to resume it after a stop
+struct TopMovesProgress {
+    std::vector<Gen> moves;          // root moves in search order, set by the first call
+    size_t next = 0;                 // first root move not searched yet
+    std::vector<ScoredMove> results; // best lines among moves[0 .. next)
+};
+
+// Deepest ply the search stack and PV table can hold (quiescence included)
+static const int MAX_PLY = 128;
+
+// History scores are kept within [-HISTORY_MAX, HISTORY_MAX] by the gravity update
+static const int HISTORY_MAX = 16384;
+
+// Quiet-move history indexed by [piece][to] of an earlier move, then [piece][to] of this one.
+// Pieces are mapped to 0..11 by pieceIndex().
+using ContinuationHistory = int[64][12][64];
+
+// Per-ply search state, allocated once with the Search and reused at every node
+struct SearchStackEntry {
+    std::vector<Gen> moves;  // move list, capacity kept between visits
+    std::vector<int> scores; // ordering score per move, parallel to `moves`
+    int staticEval = 0;
+    int rule50 = 0;          // plies since the last capture, pawn move or null move
+    Gen killers[2];          // non-captures that caused cutoffs at this ply
+    Gen currentMove;         // move being searched from this ply
+    std::vector<Gen> quietsTried;   // quiet moves searched so far, penalized on a cutoff
+    std::vector<Gen> capturesTried; // captures searched so far, penalized on a cutoff
+};
 
 class Search {
 
+    // Kernel microbenchmarks (core/bench/MicroBench.cpp) time orderMoves directly
+    friend class MicroBench;
+
     Board& b;
     Generate& g;
+    TranspositionTable& tt;
+
+    // Endgame tablebases (not owned), probed once few enough men are left
+    const Tablebase* tablebase = nullptr;
+
+    // Castling rights of the root position, folded into every node's hash
+    uint64_t castleKey = 0;
 
-    // Killer moves: 2 per ply (non-captures that caused cutoffs)
-    Gen killers[MAX_DEPTH][2];
+    // A castling right at the root can still be used (king and rook on their squares):
+    // tablebases don't model castling
+    bool rootCastling = false;
+
+    // Set from another thread to abandon the current search
+    std::atomic<bool> stopRequested{false};
+
+    // Hard limits checked every 1024 nodes: node budget (0 = none) and deadline
+    // (steady_clock ticks, 0 = none; atomic so it can be moved on a ponder hit)
+    long long nodeLimit = 0;
+    std::atomic<int64_t> deadline{0};
+
+    // Asked once the deadline has passed; true lets the search run on
+    std::function<bool()> onDeadline;
+
+    // nodesSearched as last published for other threads
+    std::atomic<long long> nodesPublished{0};
+
+    // Optional per-iteration report of searchPV
+    std::function<bool(int depth, int score, const std::vector<Gen>& pv)> onIteration;
+
+    // Search stack indexed by ply
+    SearchStackEntry stack[MAX_PLY];
+
+    // Position keys of the game followed by the current search path:
+    // the root sits at gameLength - 1, ply p at gameLength - 1 + p
+    std::vector<uint64_t> positionKeys;
+    int gameLength = 0;
+
+    // Triangular PV table: pvTable[ply] holds the best line from ply onwards
+    Gen pvTable[MAX_PLY][MAX_PLY];
+    int pvLength[MAX_PLY];
 
     // History heuristic: indexed by [side][from][to]
     int history[2][64][64];
 
+    // Counter-move heuristic: the quiet reply that refuted [piece][to] of the previous move
+    Gen counterMoves[12][64];
+
+    // Continuation histories keyed by the move one ply back (counter) and two plies back (follow-up)
+    std::unique_ptr<ContinuationHistory[]> counterHistory;
+    std::unique_ptr<ContinuationHistory[]> followupHistory;
+
+    // Capture history: indexed by [moving piece][to][captured piece type]
+    int captureHistory[12][64][6];
+
     // Search statistics
+    int selDepth = 0;           // deepest ply reached, quiescence included
     long long nodesSearched;
+    long long betaCutoffs;      // nodes that failed high
+    long long firstMoveCutoffs; // ... on the first move searched
+    SearchStats stats;          // remaining counters, see SearchStats
 
-    // MVV-LVA + killer + history move ordering
-    void orderMoves(std::vector<Gen>& moves, int ply, bool white);
+    // TT move + good captures (MVV-LVA) + killers + losing captures (SEE) + history move ordering.
+    // Leaves each move's score in stack[ply].scores.
+    void orderMoves(std::vector<Gen>& moves, const std::array<int8_t, 64>& board, int ply, bool white, int ttFrom = -1, int ttTo = -1);
 
     // Quiescence search: resolve captures at leaf nodes
-    int quiesce(std::array<int8_t, 64> board, bool white, int alpha, int beta, Evaluation& eval);
+    int quiesce(std::array<int8_t, 64> board, int ply, bool white, int alpha, int beta, Evaluation& eval);
 
     // Internal search with ply tracking
-    int alphabeta(std::array<int8_t, 64> board, int depth, int ply, bool white, int alpha, int beta, std::vector<Gen>* pv, Evaluation& eval);
+    // pvNode: the node lies on a principal variation and maintains pvTable
+    int alphabeta(std::array<int8_t, 64> board, int depth, int ply, bool white, int alpha, int beta, bool pvNode, Evaluation& eval);
+
+    // Root search of one iteration inside an aspiration window, widened on failure
+    int aspiration(std::array<int8_t, 64>& board, int depth, bool white, int prevScore, bool pvNode, Evaluation& eval);
+
+    // Copies the line below `ply` behind `move` into pvTable[ply]
+    void updatePV(int ply, const Gen& move);
+
+    // Loads the game's position history and fifty-move counter from the board before a search
+    void prepareRoot(const std::array<int8_t, 64>& board, bool white);
+
+    // Position at this ply already occurred on the game + search path since the last irreversible move
+    bool isRepetition(int ply, uint64_t key) const;
+
+    // Scores every root move from the tablebase (white's view, best first).
+    // False if the position isn't covered.
+    bool probeRoot(const std::array<int8_t, 64>& board, bool white, std::vector<ScoredMove>& out);
+
+    // Publishes the node count and stops the search once a limit is reached
+    void checkLimits();
+
+    // Appends the time of an iteration that just completed to the statistics
+    void recordIteration(std::chrono::steady_clock::time_point started);
 
     // Store a killer move
     void storeKiller(int ply, const Gen& move);
@@ -46,8 +185,29 @@ class Search {
     // Check if move is a killer
     bool isKiller(int ply, const Gen& move) const;
 
+    // Continuation history entries for `move` at this ply (nullptr when the earlier move is unknown)
+    int* counterEntry(int ply, const Gen& move) const;
+    int* followupEntry(int ply, const Gen& move) const;
+
+    // Combined quiet-move history score used for ordering
+    int quietScore(int ply, bool white, const Gen& move) const;
+
+    // Reward the move that caused a beta cutoff and penalize the moves tried before it
+    void updateHistories(int ply, bool white, int depth, const Gen& best);
+
 public:
-    Search(Board& b, Generate& g) : b(b), g(g), nodesSearched(0) {
+    Search(Board& b, Generate& g, TranspositionTable& tt)
+        : b(b), g(g), tt(tt),
+          counterHistory(std::make_unique<ContinuationHistory[]>(12)),
+          followupHistory(std::make_unique<ContinuationHistory[]>(12)),
+          nodesSearched(0), betaCutoffs(0), firstMoveCutoffs(0) {
+        for (auto& entry : stack) {
+            entry.moves.reserve(256);
+            entry.scores.reserve(256);
+            entry.quietsTried.reserve(256);
+            entry.capturesTried.reserve(256);
+        }
+        for (auto& len : pvLength) len = 0;
         clearHistory();
     }
 
@@ -56,20 +216,86 @@ public:
             for (int f = 0; f < 64; f++)
                 for (int t = 0; t < 64; t++)
                     history[s][f][t] = 0;
-        for (int d = 0; d < MAX_DEPTH; d++) {
-            killers[d][0] = {0, 0, 0, 0, false};
-            killers[d][1] = {0, 0, 0, 0, false};
+        for (auto& row : counterMoves)
+            for (auto& m : row) m = Gen{};
+        std::fill_n(&counterHistory[0][0][0][0], 12 * 64 * 12 * 64, 0);
+        std::fill_n(&followupHistory[0][0][0][0], 12 * 64 * 12 * 64, 0);
+        std::fill_n(&captureHistory[0][0][0], 12 * 64 * 6, 0);
+        for (auto& entry : stack) {
+            entry.killers[0] = {0, 0, 0, 0, false};
+            entry.killers[1] = {0, 0, 0, 0, false};
         }
     }
 
+    void setTablebase(const Tablebase* tb) { tablebase = tb; }
+    const Tablebase* getTablebase() const { return tablebase; }
+
     // Main entry: iterative deepening search
     int search(std::array<int8_t, 64> board, int depth, bool white, int alpha, int beta);
 
     // PV search for top-move display
     int searchPV(std::array<int8_t, 64> board, int depth, bool white, int alpha, int beta, std::vector<Gen>& pv);
 
+    // One iteration of searchPV at `depth` around the previous iteration's score, for
+    // callers that drive the deepening themselves (searches resumed across time slices).
+    // The PV is only updated when the iteration completes.
+    int searchIteration(std::array<int8_t, 64> board, int depth, bool white, int prevScore, std::vector<Gen>& pv);
+
     // Returns top N moves sorted best-first
     std::vector<ScoredMove> getTopMoves(std::array<int8_t, 64> board, int depth, bool white, int topN);
 
+    // Same, continuing from `progress` (start with an empty one). A stopped call keeps
+    // the root moves it finished there; calling again with the same position, depth and
+    // topN searches only the rest.
+    std::vector<ScoredMove> getTopMoves(std::array<int8_t, 64> board, int depth, bool white, int topN,
+                                        TopMovesProgress& progress);
+
     long long getNodesSearched() const { return nodesSearched; }
+    int getSelDepth() const { return selDepth; }
+
+    // Node count readable from other threads during a search (refreshed every 1024 nodes)
+    long long getNodesPublished() const { return nodesPublished.load(std::memory_order_relaxed); }
+
+    // Zeroes the node and cutoff counters (search() and searchPV() do this themselves)
+    void resetStats() {
+        selDepth = 0;
+        nodesSearched = 0;
+        betaCutoffs = firstMoveCutoffs = 0;
+        stats = SearchStats{};
+        nodesPublished.store(0, std::memory_order_relaxed);
+    }
+
+    // Called by searchPV after every completed iteration with the score (side to move's view)
+    // and PV; returning false ends the deepening there. Pass nullptr to remove.
+    void setIterationCallback(std::function<bool(int depth, int score, const std::vector<Gen>& pv)> cb) {
+        onIteration = std::move(cb);
+    }
+
+    // Hard limits for the next searches: stop after `nodes` nodes (0 = unlimited) or at `end`.
+    // The deadline may be changed while a search runs.
+    void setNodeLimit(long long nodes) { nodeLimit = nodes; }
+    void setDeadline(std::chrono::steady_clock::time_point end) {
+        deadline.store(end.time_since_epoch().count(), std::memory_order_relaxed);
+    }
+    void clearDeadline() { deadline.store(0, std::memory_order_relaxed); }
+
+    // Called (on the searching thread) when the deadline passes: returning true keeps
+    // the search going, normally after moving the deadline on. Pass nullptr to remove.
+    void setDeadlineExtension(std::function<bool()> cb) { onDeadline = std::move(cb); }
+
+    // Moves to mate of a mate score, negative when the side to move gets mated; 0 otherwise
+    static int mateDistance(int score);
+
+    // Statistics since the last resetStats()
+    SearchStats getStats() const;
+
+    // Share of beta cutoffs produced by the first move searched (move ordering quality), 0..1
+    double getFirstMoveCutoffRate() const {
+        return betaCutoffs > 0 ? (double)firstMoveCutoffs / betaCutoffs : 0.0;
+    }
+
+    // Abort a running search (thread-safe); results of the unfinished iteration are discarded
+    void stop() { stopRequested.store(true, std::memory_order_relaxed); }
+    void clearStop() { stopRequested.store(false, std::memory_order_relaxed); }
+    bool isStopped() const { return stopRequested.load(std::memory_order_relaxed); }
 };
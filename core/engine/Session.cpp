@@ -0,0 +1,378 @@
+#include "Session.h"
+#include "Trace.h"
+#include "Bench.h"
+#include "../Utils.h"
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+
+Session::Session(ApiWriter& out, TranspositionTable& tt, const Tablebase* tb, const OpeningBook* book,
+                 AnalysisCache* cache, LatencyStats* latency, bool allowPonder)
+    : out(out), tt(tt), book(book), cache(cache), latency(latency) {
+    if (allowPonder) {
+        ponder = std::make_unique<Ponder>(tt);
+        if (tb) ponder->setTablebase(tb);
+    }
+}
+
+void Session::abort() {
+    std::lock_guard<std::mutex> lock(searchMutex);
+    aborted = true;
+    if (running) running->stop();
+    if (ponder) ponder->cancel();
+}
+
+// ----------------------------------------------------------
+// Command dispatch
+// ----------------------------------------------------------
+bool Session::handle(const std::string& line, SearchWorker& w) {
+    std::istringstream in(line);
+    std::string cmd;
+    if (!(in >> cmd)) return true;
+    auto started = std::chrono::steady_clock::now();
+
+    if (cmd == "isready") {
+        out.ready();
+    }
+    else if (cmd == "newgame") {
+        if (ponder) ponder->cancel();
+        ponderHit = false;
+        expectedLine.clear();
+        b = Board();
+        out.newGame();
+    }
+    else if (cmd == "position") {
+        // Jump straight to a position: "position fen <fen> [moves ...]",
+        // "position startpos [moves ...]" or "position epd <epd>"
+        std::string spec, error;
+        std::getline(in >> std::ws, spec);
+
+        if (ponder) ponder->cancel();
+        if (setupPosition(b, spec, error)) {
+            ponderHit = false;
+            expectedLine.clear();
+            out.positionOk(b.toFen(), b.getTurn());
+        } else {
+            out.error(error);
+        }
+    }
+    else if (cmd == "fen") {
+        out.fen(b.toFen());
+    }
+    else if (cmd == "move") {
+        // "e2e4" or "e2-e4"
+        std::string moveStr;
+        in >> moveStr;
+        if (playMove(moveStr)) {
+            b.nextTurn();
+            out.moveOk(b.getTurn());
+        } else {
+            out.illegalMove();
+        }
+    }
+    else if (cmd == "search") {
+        int d = 0;
+        in >> d;
+        search(std::max(d, 1), w);
+    }
+    else if (cmd == "bench") {
+        // "bench [depth] [threads]": fixed search of the built-in suite
+        int d = Bench::DEFAULT_DEPTH, threads = 1;
+        in >> d >> threads;
+        out.bench(Bench::run(d, threads));
+    }
+    else if (cmd == "ponder") {
+        // Search the expected reply in the background until the next move arrives
+        int d = 0;
+        in >> d;
+
+        if (!ponder) {
+            out.error("ponder_unavailable");
+        } else if (!expectedLine.empty() && ponder->start(b, expectedLine[0], d, 3)) {
+            ponderHit = false;
+            out.pondering(expectedLine[0]);
+        } else {
+            out.error("no_ponder_move");
+        }
+    }
+    else if (cmd == "stats") {
+        // Latency distributions of this process, for SLO monitoring
+        if (latency) out.latency(*latency);
+        else out.error("stats_unavailable");
+    }
+    else if (cmd == "quit") {
+        return false;
+    }
+
+    if (latency) latency->record(LatencyStats::commandOf(cmd), started);
+    return true;
+}
+
+// ----------------------------------------------------------
+// Moves: keeps the ponder search on a hit, drops it on a miss
+// ----------------------------------------------------------
+bool Session::playMove(std::string& move) {
+    std::pair<std::string, std::string> coords = getCoord(move);
+    int from = getIndex(coords.first);
+    int to = getIndex(coords.second);
+
+    if (from < 0 || from > 63 || to < 0 || to > 63 || from == to) return false;
+
+    // Piece of the side not to move
+    const std::array<int8_t, 64>& board = b.getBoard();
+    if ((board[from] > 0 && b.isBlackTurn()) || (board[from] < 0 && b.isWhiteTurn())) {
+        out.error("not_your_turn");
+        return false;
+    }
+
+    if (!p.move(from, to)) return false;
+
+    if (ponder && ponder->matches(from, to)) {
+        ponderHit = true;
+    } else {
+        if (ponder) ponder->cancel();
+        ponderHit = false;
+    }
+
+    if (!expectedLine.empty() && expectedLine[0].from == from && expectedLine[0].to == to) {
+        expectedLine.erase(expectedLine.begin());
+    } else {
+        expectedLine.clear();
+    }
+    return true;
+}
+
+// ----------------------------------------------------------
+// search <depth>: book, ponder hit, cached analysis, or a fresh search on the worker
+// ----------------------------------------------------------
+bool Session::answerWithoutSearch(int d, SearchReply& r) {
+    r.ponderhit = ponder && ponderHit && ponder->getDepth() == d;
+    CachedAnalysis cached;
+
+    // Book positions are answered without searching: heaviest move first
+    std::vector<BookMove> bookMoves;
+    if (!r.ponderhit && book) bookMoves = book->probe(b, g);
+
+    if (!bookMoves.empty()) {
+        if (ponder) ponder->cancel();
+        r.book = true;
+        for (size_t i = 0; i < bookMoves.size() && i < 3; i++) {
+            r.best.push_back({{bookMoves[i].move}, 0});
+        }
+    } else if (r.ponderhit) {
+        // The position was already being searched on the opponent's time
+        long long nodes;
+        double spent;
+        r.best = ponder->finish(r.score, nodes, spent);
+    } else if (cache && cache->lookup(b, d, cached)) {
+        // Analysed before, at least this deep
+        if (ponder) ponder->cancel();
+        r.cached = true;
+        r.score = cached.eval;
+        r.best = cached.lines;
+    } else {
+        if (ponder) ponder->cancel();
+        return false;
+    }
+    return true;
+}
+
+bool Session::beginSearch(Search& s) {
+    std::lock_guard<std::mutex> lock(searchMutex);
+    if (aborted) return false;
+    running = &s;
+    s.clearStop();
+    return true;
+}
+
+bool Session::endSearch() {
+    std::lock_guard<std::mutex> lock(searchMutex);
+    running = nullptr;
+    return !aborted;
+}
+
+void Session::sendInfo(Search& s, int depth, int score, long long nodes, const std::vector<Gen>& pv,
+                       std::chrono::steady_clock::time_point started) {
+    bool white = b.getTurn();
+    SearchInfo info;
+    info.depth = depth;
+    info.selDepth = std::max(s.getSelDepth(), depth);
+    info.score = white ? score : -score;
+    info.mate = white ? Search::mateDistance(score) : -Search::mateDistance(score);
+    info.nodes = nodes;
+    info.timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count();
+    info.nps = info.nodes * 1000 / std::max(info.timeMs, 1LL);
+    info.hashfull = tt.hashfull();
+    info.pv = pv;
+    out.info(info);
+}
+
+void Session::reply(int d, const SearchReply& r) {
+    ponderHit = false;
+
+    if (cache && !r.book && !r.cached && !r.best.empty()) {
+        cache->store(b, {d, r.score, r.best});
+    }
+
+    expectedLine = r.best.empty() ? std::vector<Gen>{} : r.best[0].line;
+
+    if (r.searched) out.stats(r.stats);
+    out.bestmove(r.score, r.ponderhit, r.book, r.cached, r.best);
+}
+
+void Session::search(int d, SearchWorker& w) {
+    TraceSpan span("search request", "session", "depth", d);
+    SearchReply r;
+    if (!answerWithoutSearch(d, r)) {
+        if (!beginSearch(w.s)) return;
+
+        // Stream an "info" line per completed depth so the client can show
+        // progress long before the final result
+        w.board = b;
+        bool white = b.getTurn();
+        auto started = std::chrono::steady_clock::now();
+        w.s.setIterationCallback([&](int depth, int iterScore, const std::vector<Gen>& pv) {
+            sendInfo(w.s, depth, iterScore, w.s.getNodesSearched(), pv, started);
+            return true;
+        });
+
+        std::vector<Gen> pv;
+        r.score = w.s.searchPV(w.board.getBoard(), d, white, -2000000, 2000000, pv);
+        w.s.setIterationCallback(nullptr);
+        if (!white) r.score = -r.score; // Normalize to White-relative
+        r.best = w.s.getTopMoves(w.board.getBoard(), d, white, 3);
+        r.stats = w.s.getStats(); // getTopMoves adds to the counters of searchPV
+        r.searched = true;
+
+        if (!endSearch()) return;
+        if (latency) latency->recordSearch(d, r.stats.nodes, started);
+    }
+    reply(d, r);
+}
+
+// ----------------------------------------------------------
+// Cooperative search: the same work cut into turns of the scheduler.
+// A turn ends after its time slice, checked at the search's node-count checkpoints, but
+// only if another task is waiting for the thread; alone, a search runs on uncut.
+// An iteration cut short is searched again on the next turn, mostly from what it left
+// in the transposition table, with the slice doubled until it completes; one cut at
+// MAX_SLICE and the next turn runs it to the end, so a request that can't fit in a
+// slice still answers. The top lines resume from the first root move not yet finished.
+// ----------------------------------------------------------
+Task Session::run(std::string line, Scheduler& scheduler) {
+    std::istringstream in(line);
+    std::string cmd;
+    in >> cmd;
+
+    if (cmd == "search") {
+        // Timed here: the search spans many turns, queueing between them included
+        auto started = std::chrono::steady_clock::now();
+        int d = 0;
+        in >> d;
+        co_await searchSliced(std::max(d, 1), scheduler);
+        if (latency) latency->record(LatencyStats::SEARCH, started);
+    } else if (cmd == "bench") {
+        // Runs its own threads for as long as it takes: it would starve every session
+        out.error("bench_unavailable");
+    } else {
+        handle(line, Scheduler::worker());
+    }
+}
+
+Task Session::searchSliced(int d, Scheduler& scheduler) {
+    SearchReply r;
+    if (answerWithoutSearch(d, r)) {
+        reply(d, r);
+        co_return;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    bool white = b.getTurn();
+    auto started = Clock::now();
+    std::vector<Gen> pv;
+    long long nodes = 0;
+    std::chrono::milliseconds quantum = Scheduler::SLICE;
+    Clock::time_point turnEnd = started + quantum;
+    // At the end of a slice the search only gives way if another task is waiting
+    auto runOnWhenAlone = [&](Search& s) {
+        s.setDeadlineExtension([&scheduler, &s, &quantum] {
+            if (scheduler.hasWaiting()) return false;
+            s.setDeadline(Clock::now() + quantum);
+            return true;
+        });
+    };
+
+    bool uncut = false; // cut at MAX_SLICE: the next turn finishes the step
+
+    // Limits the turn to its slice, or lets it finish the step
+    auto limitTurn = [&](Search& s) {
+        if (uncut) {
+            s.clearDeadline();
+            return;
+        }
+        s.setDeadline(turnEnd);
+        runOnWhenAlone(s);
+    };
+
+    // After a cut: a longer slice next turn, or no limit past MAX_SLICE
+    auto widenSlice = [&] {
+        if (quantum >= Scheduler::MAX_SLICE) uncut = true;
+        quantum = std::min(quantum * 2, Scheduler::MAX_SLICE);
+    };
+
+    // Iterative deepening, one depth per step
+    for (int depth = 1; depth <= d; ) {
+        SearchWorker& w = Scheduler::worker();
+        if (!beginSearch(w.s)) co_return;
+        w.board = b;
+        limitTurn(w.s);
+        int iterScore = w.s.searchIteration(w.board.getBoard(), depth, white, r.score, pv);
+        bool cut = w.s.isStopped();
+        w.s.clearDeadline();
+        w.s.setDeadlineExtension(nullptr);
+        nodes += w.s.getNodesSearched();
+        r.stats.add(w.s.getStats());
+        if (!endSearch()) co_return;
+
+        if (!cut) {
+            r.score = iterScore;
+            sendInfo(w.s, depth, iterScore, nodes, pv, started);
+            depth++;
+            quantum = Scheduler::SLICE;
+            uncut = false;
+        } else {
+            widenSlice();
+        }
+        if (cut || Clock::now() >= turnEnd) {
+            co_await scheduler.yield();
+            turnEnd = Clock::now() + quantum;
+        }
+    }
+    if (!white) r.score = -r.score; // Normalize to White-relative
+
+    // Top lines: a cut step keeps the root moves it finished, the next one goes on from
+    // the first unfinished move
+    TopMovesProgress progress;
+    for (;;) {
+        SearchWorker& w = Scheduler::worker();
+        if (!beginSearch(w.s)) co_return;
+        w.board = b;
+        limitTurn(w.s);
+        w.s.resetStats();
+        r.best = w.s.getTopMoves(w.board.getBoard(), d, white, 3, progress);
+        bool cut = w.s.isStopped();
+        w.s.clearDeadline();
+        w.s.setDeadlineExtension(nullptr);
+        r.stats.add(w.s.getStats());
+        if (!endSearch()) co_return;
+        if (!cut) break;
+
+        widenSlice();
+        co_await scheduler.yield();
+        turnEnd = Clock::now() + quantum;
+    }
+
+    r.searched = true;
+    if (latency) latency->recordSearch(d, r.stats.nodes, started);
+    reply(d, r);
+}
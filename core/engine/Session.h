@@ -0,0 +1,108 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../board/Board.h"
+#include "../board/Piece.h"
+#include "../board/Generate.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+#include "Tablebase.h"
+#include "OpeningBook.h"
+#include "AnalysisCache.h"
+#include "LatencyStats.h"
+#include "Ponder.h"
+#include "ApiWriter.h"
+#include "Scheduler.h"
+
+// Search state a session borrows for one search. The position is copied onto the
+// worker's own board; histories stay warm from one search (and session) to the next.
+struct SearchWorker {
+    Board board;
+    Generate g{board};
+    Search s;
+    explicit SearchWorker(TranspositionTable& tt, const Tablebase* tb = nullptr) : s(board, g, tt) {
+        if (tb) s.setTablebase(tb);
+    }
+};
+
+// One game of the --api protocol: its board, expected line and ponder search.
+// Commands arrive one line at a time and are answered through the session's writer.
+// Used by the stdin/stdout API (one session) and by the daemon (many sessions that
+// share the transposition table and a pool of SearchWorkers).
+class Session {
+
+    Board b;
+    Piece p{b};
+    Generate g{b};
+
+    ApiWriter& out;
+    TranspositionTable& tt;
+    const OpeningBook* book;
+    AnalysisCache* cache;
+    LatencyStats* latency;
+
+    // Background search of the expected reply; absent when pondering is disabled
+    std::unique_ptr<Ponder> ponder;
+    bool ponderHit = false;
+
+    // Engine's expected continuation from the current position
+    std::vector<Gen> expectedLine;
+
+    // Search currently running for this session, so abort() can reach it
+    std::mutex searchMutex;
+    Search* running = nullptr;
+    bool aborted = false;
+
+    // Reply to "search <depth>" as it is put together (scores white-relative)
+    struct SearchReply {
+        int score = 0;
+        std::vector<ScoredMove> best;
+        bool ponderhit = false;
+        bool book = false;
+        bool cached = false;
+        bool searched = false; // `stats` is set
+        SearchStats stats;
+    };
+
+    bool playMove(std::string& move);
+
+    // Book move, ponder hit or cached analysis; false if the position needs a search
+    bool answerWithoutSearch(int depth, SearchReply& r);
+
+    // Registers `s` as the running search (false once aborted) and unregisters it
+    // (false if aborted meanwhile: no reply then)
+    bool beginSearch(Search& s);
+    bool endSearch();
+
+    void sendInfo(Search& s, int depth, int score, long long nodes, const std::vector<Gen>& pv,
+                  std::chrono::steady_clock::time_point started);
+    void reply(int depth, const SearchReply& r);
+
+    void search(int depth, SearchWorker& w);
+    Task searchSliced(int depth, Scheduler& scheduler);
+
+public:
+
+    // `latency` (optional, may be shared by sessions) times every command for "stats"
+    Session(ApiWriter& out, TranspositionTable& tt, const Tablebase* tb, const OpeningBook* book,
+            AnalysisCache* cache, LatencyStats* latency, bool allowPonder);
+    ~Session() { if (ponder) ponder->cancel(); }
+
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+
+    // Runs one command line; false once the session is over ("quit")
+    bool handle(const std::string& line, SearchWorker& w);
+
+    // handle() as a task of the scheduler's pool: a search runs in time-sliced turns
+    // that leave room for other sessions; other commands complete in one turn, and
+    // "bench" is refused
+    Task run(std::string line, Scheduler& scheduler);
+
+    // Stops the running search (thread-safe) and refuses further ones
+    void abort();
+};
@@ -7,81 +7,43 @@
 #include "../board/Board.h"
 #include "../board/Generate.h"
 #include "../engine/Search.h"
+#include "../engine/Session.h"
+#include <cstdlib>
+
+// --------------------------------------------------------
+// Tablebases from $CHESS_TABLEBASES or ./tablebases (built with --gen-tb),
+// opening book from $CHESS_BOOK or ./book.bin (built with --build-book),
+// hash table shared with other engine processes if $CHESS_SHARED_HASH names one,
+// persistent analysis cache (API mode) if $CHESS_ANALYSIS_CACHE names a file
+// --------------------------------------------------------
+Shell::Shell(bool api, bool binary) : binary(binary), apiMode(api) {
+    tt.attachSharedFromEnvironment();
+
+    const char* dir = std::getenv("CHESS_TABLEBASES");
+    if (tablebase.open(dir ? dir : "tablebases") > 0) {
+        s.setTablebase(&tablebase);
+        ponder.setTablebase(&tablebase);
+    }
+
+    const char* bookPath = std::getenv("CHESS_BOOK");
+    book.open(bookPath ? bookPath : "book.bin");
+
+    if (apiMode) cache.openFromEnvironment();
+}
 
 int Shell::run() {
     const int depth = 6;
 
     if (apiMode) {
-        // API Mode: Loop listening for commands on stdin
-        // Output JSON to stdout
-        
-        // Initial "ready" signal if needed, or just wait.
-        std::string cmd;
-        while (std::cin >> cmd) {
-            if (cmd == "isready") {
-                std::cout << "{\"ready\": true}" << std::endl;
-            } 
-            else if (cmd == "newgame") {
-                // Reset board
-                b = Board(); // Re-assign default board
-                // Reset any other state if needed
-                std::cout << "{\"status\": \"new_game_started\"}" << std::endl;
-            }
-            else if (cmd == "move") {
-                std::string moveStr;
-                std::cin >> moveStr;
-                // Parse move string (e.g., "e2e4" or "e2-e4")
-                bool valid = handleMove(moveStr); // handleMove prints errors to stdout which might break JSON, we need to be careful.
-                // handleMove currently prints to stdout. We should probably refactor handleMove to NOT print if apiMode is set, or capture it.
-                // For now, let's assume valid moves.
-                if (valid) {
-                     b.nextTurn(); // Switch turn after successful move
-                     std::cout << "{\"status\": \"move_ok\", \"turn\": " << (b.getTurn() ? "\"white\"" : "\"black\"") << "}" << std::endl;
-                } else {
-                     std::cout << "{\"status\": \"illegal_move\"}" << std::endl;
-                }
-            }
-            else if (cmd == "search") {
-                int d;
-                std::cin >> d;
-                int score = s.search(b.getBoard(), d, b.getTurn(), -2000000, 2000000);
-                if (!b.getTurn()) score = -score; // Normalize to White-relative
-                std::vector<ScoredMove> best = s.getTopMoves(b.getBoard(), d, b.getTurn(), 3);
-                
-                std::cout << "{";
-                std::cout << "\"eval\": " << score << ", ";
-
-                // bestmove (first move of best line)
-                if (!best.empty() && !best[0].line.empty()) {
-                    Gen& bestMove = best[0].line[0];
-                    std::string mStr = indexToAlgebraic(bestMove.from) + indexToAlgebraic(bestMove.to);
-                    std::cout << "\"bestmove\": \"" << mStr << "\", ";
-                } else {
-                    std::cout << "\"bestmove\": null, ";
-                }
-
-                // topMoves array
-                std::cout << "\"topMoves\": [";
-                for (size_t i = 0; i < best.size(); i++) {
-                    if (i > 0) std::cout << ", ";
-                    std::cout << "{";
-                    std::cout << "\"score\": " << best[i].score << ", ";
-                    std::cout << "\"line\": [";
-                    for (size_t j = 0; j < best[i].line.size(); j++) {
-                        if (j > 0) std::cout << ", ";
-                        std::string mv = indexToAlgebraic(best[i].line[j].from) + indexToAlgebraic(best[i].line[j].to);
-                        std::cout << "\"" << mv << "\"";
-                    }
-                    std::cout << "]}";
-                }
-                std::cout << "]";
-
-                std::cout << "}" << std::endl;
-            }
-            else if (cmd == "quit") {
-                break;
-            }
-        }
+        // API Mode: one session, commands on stdin, replies on stdout
+        ApiWriter out(binary);
+        SearchWorker worker(tt, tablebase.maxPieces() > 0 ? &tablebase : nullptr);
+        auto latency = std::make_unique<LatencyStats>();
+        Session session(out, tt, worker.s.getTablebase(), &book, cache.isOpen() ? &cache : nullptr,
+                        latency.get(), true);
+
+        std::string line;
+        while (std::getline(std::cin, line) && session.handle(line, worker)) {}
         return 0;
     }
 
@@ -125,6 +87,12 @@ int Shell::run() {
             }
         }
 
+        if (b.isThreefoldRepetition() || b.isFiftyMoveDraw()) {
+            b.printBoard();
+            std::cout << (b.isFiftyMoveDraw() ? "Draw by the fifty-move rule.\n" : "Draw by threefold repetition.\n");
+            return 0;
+        }
+
         if (legalMoves.empty()) {
             b.printBoard();
             if (c.isCheck(turn)) {
@@ -147,67 +115,17 @@ int Shell::run() {
 
         // --- Human's turn (or analysis mode) ---
 
-        // Engine evaluation (timed)
-        auto t0 = std::chrono::steady_clock::now();
-
-        int score = s.search(b.getBoard(), depth, turn, -2000000, 2000000);
-        int absScore = turn ? score : -score;
-
-        double whiteProb = toWinPercent(absScore);
-        double blackProb = 100.0 - whiteProb;
-
-        // Top moves
-        std::vector<ScoredMove> topMoves = s.getTopMoves(b.getBoard(), depth, turn, 3);
+        // A ponder search started at an earlier prompt is stale now
+        ponder.cancel();
 
-        auto t1 = std::chrono::steady_clock::now();
-        double elapsed = std::chrono::duration<double>(t1 - t0).count();
-
-        b.printBoard();
-
-        // ANSI formatting
-        const char* BOLD  = "\033[1m";
-        const char* DIM   = "\033[2m";
-        const char* GREEN = "\033[32m";
-        const char* CYAN  = "\033[36m";
-        const char* YELLOW = "\033[33m";
-        const char* RST   = "\033[0m";
-
-        std::cout << std::fixed << std::setprecision(1);
-
-        // Eval bar
-        int barWidth = 20;
-        int whiteBars = (int)(whiteProb / 100.0 * barWidth);
-        std::cout << "  " << BOLD << "⚪ " << whiteProb << "%" << RST << " ";
-        for (int i = 0; i < barWidth; i++) {
-            if (i < whiteBars) std::cout << "\033[47m ";
-            else std::cout << "\033[40m ";
-        }
-        std::cout << RST << " " << BOLD << blackProb << "% ⚫" << RST << "\n";
-
-        std::cout << DIM << "  eval " << absScore << " · " << s.getNodesSearched() << " nodes · " << std::setprecision(2) << elapsed << "s" << RST << "\n\n";
-
-        // Best lines
-        std::cout << CYAN << "  ── Best lines for " << (turn ? "White" : "Black") << " ──" << RST << "\n";
-        for (int i = 0; i < (int)topMoves.size(); i++) {
-            ScoredMove& sm = topMoves[i];
-            
-            std::cout << "  " << YELLOW << (i + 1) << "." << RST << " ";
-            for (int j = 0; j < (int)sm.line.size(); j++) {
-                if (j > 0) std::cout << " ";
-                // Detect castling notation
-                Gen& m = sm.line[j];
-                if (std::abs(m.piece) == 6 && std::abs(m.to - m.from) == 2) {
-                    std::cout << (m.to > m.from ? "O-O" : "O-O-O");
-                } else {
-                    std::cout << indexToAlgebraic(m.from) << indexToAlgebraic(m.to);
-                    if (m.promotion) std::cout << "=Q";
-                }
-            }
-            std::cout << DIM << " (" << sm.score << ")" << RST << "\n";
+        // Book positions are shown without searching
+        if (!showBookMoves(turn)) {
+            showAnalysis(turn, depth);
         }
-        std::cout << "\n";
 
         // Move prompt
+        const char* BOLD = "\033[1m";
+        const char* RST  = "\033[0m";
         std::cout << BOLD << "  " << (turn ? "White" : "Black") << " ▸ " << RST;
         std::string move;
         std::cin >> move;
@@ -224,19 +142,153 @@ int Shell::run() {
             continue;
         }
 
+        std::pair<std::string, std::string> coords = getCoord(move);
+        onMovePlayed(getIndex(coords.first), getIndex(coords.second));
+
         b.nextTurn();
     }
 
     return 0;
 }
 
+// --------------------------------------------------------
+// Book moves of the current position with their share of the weight;
+// false when out of book
+// --------------------------------------------------------
+bool Shell::showBookMoves(bool turn) {
+    std::vector<BookMove> bookMoves = book.probe(b, g);
+    if (bookMoves.empty()) return false;
+
+    b.printBoard();
+
+    int total = 0;
+    for (const BookMove& bm : bookMoves) total += bm.weight;
+
+    std::cout << "\033[36m  ── Book moves for " << (turn ? "White" : "Black") << " ──\033[0m\n";
+    std::cout << std::fixed << std::setprecision(0);
+    for (const BookMove& bm : bookMoves) {
+        const Gen& m = bm.move;
+        std::cout << "  ";
+        if (std::abs(m.piece) == 6 && std::abs(m.to - m.from) == 2) {
+            std::cout << (m.to > m.from ? "O-O" : "O-O-O");
+        } else {
+            std::cout << indexToAlgebraic(m.from) << indexToAlgebraic(m.to);
+        }
+        std::cout << "\033[2m (" << 100.0 * bm.weight / total << "%)\033[0m\n";
+    }
+    std::cout << "\n";
+    return true;
+}
+
+// --------------------------------------------------------
+// Evaluation, best lines and pondering for the position at the prompt
+// --------------------------------------------------------
+void Shell::showAnalysis(bool turn, int depth) {
+    // Engine evaluation (timed)
+    auto t0 = std::chrono::steady_clock::now();
+
+    int score = s.search(b.getBoard(), depth, turn, -2000000, 2000000);
+    int absScore = turn ? score : -score;
+
+    double whiteProb = toWinPercent(absScore);
+    double blackProb = 100.0 - whiteProb;
+
+    // Top moves
+    std::vector<ScoredMove> topMoves = s.getTopMoves(b.getBoard(), depth, turn, 3);
+
+    auto t1 = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(t1 - t0).count();
+
+    b.printBoard();
+
+    // ANSI formatting
+    const char* BOLD  = "\033[1m";
+    const char* DIM   = "\033[2m";
+    const char* GREEN = "\033[32m";
+    const char* CYAN  = "\033[36m";
+    const char* YELLOW = "\033[33m";
+    const char* RST   = "\033[0m";
+
+    std::cout << std::fixed << std::setprecision(1);
+
+    // Eval bar
+    int barWidth = 20;
+    int whiteBars = (int)(whiteProb / 100.0 * barWidth);
+    std::cout << "  " << BOLD << "⚪ " << whiteProb << "%" << RST << " ";
+    for (int i = 0; i < barWidth; i++) {
+        if (i < whiteBars) std::cout << "\033[47m ";
+        else std::cout << "\033[40m ";
+    }
+    std::cout << RST << " " << BOLD << blackProb << "% ⚫" << RST << "\n";
+
+    SearchStats stats = s.getStats();
+    std::cout << DIM << "  eval " << absScore << " · " << stats.nodes << " nodes · seldepth "
+              << stats.selDepth << " · "
+              << std::setprecision(0) << stats.firstMoveCutoffRate() * 100 << "% first-move cutoffs · "
+              << std::setprecision(2) << elapsed << "s" << RST << "\n";
+    if (stats.detailed) {
+        std::cout << DIM << std::setprecision(0)
+                  << "  qsearch " << stats.qsearchNodes << " · null move " << stats.nullMovePrunes << "/" << stats.nullMoveTries
+                  << " · rfp " << stats.rfpPrunes << " · lmr " << stats.lmrReductions << " (" << stats.lmrResearches
+                  << " re-searched) · check ext " << stats.checkExtensions << " · tt hits " << stats.ttHitRate() * 100
+                  << "% (" << stats.ttCutoffs << " cutoffs) · evals " << stats.evaluations << RST << "\n";
+    }
+    std::cout << DIM << "  iterations (ms)";
+    for (long long ms : stats.iterationMs) std::cout << " " << ms;
+    std::cout << RST << "\n\n";
+
+    // Best lines
+    std::cout << CYAN << "  ── Best lines for " << (turn ? "White" : "Black") << " ──" << RST << "\n";
+    for (int i = 0; i < (int)topMoves.size(); i++) {
+        ScoredMove& sm = topMoves[i];
+        
+        std::cout << "  " << YELLOW << (i + 1) << "." << RST << " ";
+        for (int j = 0; j < (int)sm.line.size(); j++) {
+            if (j > 0) std::cout << " ";
+            // Detect castling notation
+            Gen& m = sm.line[j];
+            if (std::abs(m.piece) == 6 && std::abs(m.to - m.from) == 2) {
+                std::cout << (m.to > m.from ? "O-O" : "O-O-O");
+            } else {
+                std::cout << indexToAlgebraic(m.from) << indexToAlgebraic(m.to);
+                if (m.promotion) std::cout << "=Q";
+            }
+        }
+        std::cout << DIM << " (" << sm.score << ")" << RST << "\n";
+    }
+    std::cout << "\n";
+
+    // Think on the human's time about the move we expect them to play
+    if (mode == GameMode::VS_AI && !topMoves.empty() && !topMoves[0].line.empty()) {
+        ponder.start(b, topMoves[0].line[0], depth, 1);
+    }
+}
+
 // --------------------------------------------------------
 // AI makes the best move automatically
 // --------------------------------------------------------
 bool Shell::makeAIMove(bool turn, int depth) {
     auto t0 = std::chrono::steady_clock::now();
 
-    std::vector<ScoredMove> topMoves = s.getTopMoves(b.getBoard(), depth, turn, 1);
+    std::vector<ScoredMove> topMoves;
+    long long nodes = 0;
+    double pondered = 0;
+    bool hit = ponderHit;
+    Gen bookMove;
+    bool fromBook = !hit && book.pick(b, g, bookMove);
+
+    if (fromBook) {
+        // Book move: no search at all
+        topMoves.push_back({{bookMove}, 0});
+    } else if (hit) {
+        // Already searched while the human was thinking; just wait for it to finish
+        int score;
+        topMoves = ponder.finish(score, nodes, pondered);
+        ponderHit = false;
+    } else {
+        topMoves = s.getTopMoves(b.getBoard(), depth, turn, 1);
+        nodes = s.getNodesSearched();
+    }
 
     auto t1 = std::chrono::steady_clock::now();
     double elapsed = std::chrono::duration<double>(t1 - t0).count();
@@ -294,7 +346,10 @@ bool Shell::makeAIMove(bool turn, int depth) {
     }
     std::cout << RST << " " << BOLD << blackProb << "% ⚫" << RST << "\n";
 
-    std::cout << DIM << "  eval " << topMoves[0].score << " · " << s.getNodesSearched() << " nodes · " << std::setprecision(2) << elapsed << "s" << RST << "\n\n";
+    std::cout << DIM << "  eval " << topMoves[0].score << " · " << nodes << " nodes · " << std::setprecision(2) << elapsed << "s";
+    if (hit) std::cout << " · ponder hit (" << pondered << "s on your time)";
+    if (fromBook) std::cout << " · book move";
+    std::cout << RST << "\n\n";
 
     // Engine move display
     std::cout << MAGENTA << "  ▸ Engine plays: " << RST << BOLD;
@@ -342,44 +397,23 @@ bool Shell::handleMove(std::string& move) {
     
     //if piece that is being moved is the opposite of whos turn it is
     if((board.at(fromIndex) > 0 && b.isBlackTurn()) || (board.at(fromIndex) < 0 && b.isWhiteTurn())) {
-        if (apiMode) {
-            std::cout << "{\"status\": \"error\", \"message\": \"not_your_turn\"}" << std::endl;
-        } else {
-            std::cout << "Not your turn";
-        }
+        std::cout << "Not your turn";
         return false;
     }
 
 
-    PieceType piece = p.getPieceType(abs(board.at(fromIndex)));
-
-    switch(piece) {
-    
-        case PieceType::PAWN:
-            return p.pawnMove(fromIndex, toIndex);
-
-        case PieceType::ROOK:
-            return p.rookMove(fromIndex, toIndex);
-
-        case PieceType::KNIGHT:
-            return p.knightMove(fromIndex, toIndex);
-
-        case PieceType::BISHOP:
-            return p.bishopMove(fromIndex, toIndex);
-
-        case PieceType::QUEEN:
-            return p.queenMove(fromIndex, toIndex);
-
-        case PieceType::KING:
-            return p.kingMove(fromIndex, toIndex);
-
-        default: p.emptyMove(fromIndex, toIndex);
-
-    };
-
-    
-    return false;
+    return p.move(fromIndex, toIndex);
 
 }
 
-
+// --------------------------------------------------------
+// Ponder bookkeeping after any move on the game board
+// --------------------------------------------------------
+void Shell::onMovePlayed(int from, int to) {
+    if (ponder.matches(from, to)) {
+        ponderHit = true;
+    } else {
+        ponder.cancel();
+        ponderHit = false;
+    }
+}
@@ -5,6 +5,11 @@
 #include "../board/Check.h"
 #include "../board/Generate.h"
 #include "../engine/Search.h"
+#include "../engine/TranspositionTable.h"
+#include "../engine/Ponder.h"
+#include "../engine/Tablebase.h"
+#include "../engine/OpeningBook.h"
+#include "../engine/AnalysisCache.h"
 
 enum class GameMode { ANALYSIS, VS_AI };
 
@@ -14,7 +19,18 @@ class Shell {
     Piece p{b};
     Check c{b};
     Generate g{b};
-    Search s{b, g};
+    TranspositionTable tt;
+    Tablebase tablebase;
+    OpeningBook book;
+    AnalysisCache cache;
+    Search s{b, g, tt};
+
+    // Background search of the expected reply while the opponent thinks
+    Ponder ponder{tt};
+    bool ponderHit = false;
+
+    // API mode replies as binary frames instead of JSON lines
+    bool binary = false;
 
     // Game mode
     GameMode mode = GameMode::ANALYSIS;
@@ -23,9 +39,16 @@ class Shell {
     // AI makes its move automatically
     bool makeAIMove(bool turn, int depth);
 
+    // Prompt display: book moves if the position is in the book, else a search
+    bool showBookMoves(bool turn);
+    void showAnalysis(bool turn, int depth);
+
+    // Called after a move is played: keeps the ponder search on a hit, drops it on a miss
+    void onMovePlayed(int from, int to);
+
 public:
 
-    Shell(bool api = false) : apiMode(api) {}
+    Shell(bool api = false, bool binary = false);
 
     bool apiMode = false;
 
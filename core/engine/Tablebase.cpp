@@ -0,0 +1,480 @@
+#include "Tablebase.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ----------------------------------------------------------
+// Piece letters, ordered strongest first
+// ----------------------------------------------------------
+static const char* PIECE_LETTERS = "QRBNP";
+
+static int letterRank(char c) {
+    const char* p = std::strchr(PIECE_LETTERS, c);
+    return p ? (int)(p - PIECE_LETTERS) : -1;
+}
+
+static int8_t letterPiece(char c) {
+    switch (c) {
+        case 'Q': return 5;
+        case 'R': return 2;
+        case 'B': return 3;
+        case 'N': return 4;
+        case 'P': return 1;
+        default: return 0;
+    }
+}
+
+static char pieceLetter(int piece) {
+    switch (std::abs(piece)) {
+        case 5: return 'Q';
+        case 2: return 'R';
+        case 3: return 'B';
+        case 4: return 'N';
+        case 1: return 'P';
+        default: return '?';
+    }
+}
+
+// ----------------------------------------------------------
+// Board symmetries and white king regions
+// ----------------------------------------------------------
+
+// t bit 0: mirror files, bit 1: mirror ranks, bit 2: swap files and ranks (diagonal)
+static int transform(int sq, int t) {
+    int f = sq & 7;
+    int r = sq >> 3;
+    if (t & 1) f = 7 - f;
+    if (t & 2) r = 7 - r;
+    if (t & 4) std::swap(f, r);
+    return r * 8 + f;
+}
+
+struct KingRegions {
+    int triangle[64];   // a1-d1-d4 triangle, used without pawns (10 squares)
+    int triangleSq[10];
+    int half[64];       // files a-d, used with pawns (32 squares)
+    int halfSq[32];
+
+    KingRegions() {
+        int n = 0;
+        for (int sq = 0; sq < 64; sq++) {
+            int f = sq & 7, r = sq >> 3;
+            triangle[sq] = (f <= 3 && r <= f) ? n : -1;
+            if (triangle[sq] >= 0) triangleSq[n++] = sq;
+            half[sq] = f <= 3 ? r * 4 + f : -1;
+            if (half[sq] >= 0) halfSq[half[sq]] = sq;
+        }
+    }
+};
+
+static const KingRegions& regions() {
+    static const KingRegions r;
+    return r;
+}
+
+// ----------------------------------------------------------
+// Material names
+// ----------------------------------------------------------
+std::string Tablebase::canonicalName(std::string white, std::string black, bool* flipped) {
+    auto byRank = [](char a, char b) { return letterRank(a) < letterRank(b); };
+    std::sort(white.begin(), white.end(), byRank);
+    std::sort(black.begin(), black.end(), byRank);
+
+    // More pieces is stronger; otherwise the first stronger piece decides
+    bool blackStronger = black.size() > white.size();
+    if (black.size() == white.size()) {
+        for (size_t i = 0; i < white.size(); i++) {
+            if (white[i] != black[i]) {
+                blackStronger = letterRank(black[i]) < letterRank(white[i]);
+                break;
+            }
+        }
+    }
+
+    if (flipped) *flipped = blackStronger;
+    if (blackStronger) std::swap(white, black);
+    return "K" + white + "vK" + black;
+}
+
+bool Tablebase::parseMaterial(const std::string& name, TBMaterial& out) {
+    size_t v = name.find('v');
+    if (v == std::string::npos || name.size() < 4 || name[0] != 'K' || name[v + 1] != 'K') return false;
+
+    std::string white = name.substr(1, v - 1);
+    std::string black = name.substr(v + 2);
+    if (white.size() + black.size() > 6) return false;
+    for (char c : white + black) {
+        if (letterRank(c) < 0) return false;
+    }
+    if (canonicalName(white, black) != name) return false;
+
+    out.name = name;
+    out.count = 0;
+    out.hasPawns = false;
+    for (char c : white) out.pieces[out.count++] = letterPiece(c);
+    for (char c : black) out.pieces[out.count++] = -letterPiece(c);
+    for (int i = 0; i < out.count; i++) {
+        if (std::abs(out.pieces[i]) == 1) out.hasPawns = true;
+    }
+
+    out.size = out.hasPawns ? 32 : 10;
+    for (int i = 1; i < out.men(); i++) out.size *= 64;
+    out.size *= 2;
+    return true;
+}
+
+// ----------------------------------------------------------
+// Indexing
+// ----------------------------------------------------------
+uint64_t Tablebase::encode(const TBMaterial& m, const int* squares, bool white) {
+    const KingRegions& kr = regions();
+    int men = m.men();
+    int symmetries = m.hasPawns ? 2 : 8; // pawns only allow mirroring the files
+    uint64_t best = UINT64_MAX;
+
+    for (int t = 0; t < symmetries; t++) {
+        int wk = transform(squares[0], t);
+        int region = m.hasPawns ? kr.half[wk] : kr.triangle[wk];
+        if (region < 0) continue;
+
+        int sq[8];
+        for (int i = 0; i < men; i++) sq[i] = transform(squares[i], t);
+
+        // Identical pieces are interchangeable: keep their squares ascending
+        for (int i = 3; i < men; i++) {
+            for (int j = i; j > 2 && m.pieces[j - 2] == m.pieces[j - 3] && sq[j] < sq[j - 1]; j--) {
+                std::swap(sq[j], sq[j - 1]);
+            }
+        }
+
+        uint64_t index = region;
+        for (int i = 1; i < men; i++) index = index * 64 + sq[i];
+        if (!white) index += m.size / 2;
+        best = std::min(best, index);
+    }
+
+    return best;
+}
+
+void Tablebase::decode(const TBMaterial& m, uint64_t index, int* squares, bool& white) {
+    const KingRegions& kr = regions();
+    white = index < m.size / 2;
+    if (!white) index -= m.size / 2;
+
+    for (int i = m.men() - 1; i >= 1; i--) {
+        squares[i] = (int)(index % 64);
+        index /= 64;
+    }
+    squares[0] = m.hasPawns ? kr.halfSq[index] : kr.triangleSq[index];
+}
+
+bool Tablebase::locate(const std::array<int8_t, 64>& board, bool white, std::string& name, uint64_t& index) {
+    struct Placed { int8_t piece; int sq; };
+    std::vector<Placed> own, opp;
+    int wk = -1, bk = -1;
+    std::string whiteLetters, blackLetters;
+
+    for (int sq = 0; sq < 64; sq++) {
+        int8_t p = board[sq];
+        if (p == 6) wk = sq;
+        else if (p == -6) bk = sq;
+        else if (p != 0) {
+            if (own.size() + opp.size() == 6) return false;
+            if (p > 0) { own.push_back({p, sq}); whiteLetters += pieceLetter(p); }
+            else       { opp.push_back({p, sq}); blackLetters += pieceLetter(p); }
+        }
+    }
+    if (wk < 0 || bk < 0 || own.size() + opp.size() == 0) return false;
+
+    bool flipped;
+    name = canonicalName(whiteLetters, blackLetters, &flipped);
+
+    // Colors the other way round: mirror the ranks and swap sides
+    if (flipped) {
+        std::swap(own, opp);
+        int k = wk;
+        wk = bk ^ 56;
+        bk = k ^ 56;
+        for (Placed& p : own) { p.piece = -p.piece; p.sq ^= 56; }
+        for (Placed& p : opp) { p.piece = -p.piece; p.sq ^= 56; }
+        white = !white;
+    }
+
+    auto byRank = [](const Placed& a, const Placed& b) {
+        return letterRank(pieceLetter(a.piece)) < letterRank(pieceLetter(b.piece));
+    };
+    std::sort(own.begin(), own.end(), byRank);
+    std::sort(opp.begin(), opp.end(), byRank);
+
+    TBMaterial m;
+    if (!parseMaterial(name, m)) return false;
+    int squares[8] = {wk, bk};
+    int n = 2;
+    for (const Placed& p : own) squares[n++] = p.sq;
+    for (const Placed& p : opp) squares[n++] = p.sq;
+
+    index = encode(m, squares, white);
+    return true;
+}
+
+int Tablebase::countMen(const std::array<int8_t, 64>& board) {
+    int n = 0;
+    for (int8_t p : board) n += p != 0;
+    return n;
+}
+
+// Nothing but the two kings: a draw no table has to hold
+static bool bareKings(const std::array<int8_t, 64>& board) {
+    int kings = 0, others = 0;
+    for (int8_t p : board) {
+        if (p == 6 || p == -6) kings++;
+        else if (p != 0) others++;
+    }
+    return kings == 2 && others == 0;
+}
+
+// ----------------------------------------------------------
+// File format: header, block offsets, RLE data
+// ----------------------------------------------------------
+struct TBFileHeader {
+    char magic[4];          // "CETB"
+    uint32_t version;
+    uint64_t entries;
+    uint32_t blockEntries;
+    uint32_t encoding;      // TB_RUNS or TB_PACKED_RUNS
+    uint64_t blockCount;    // followed by blockCount + 1 offsets into the data
+};
+
+static const uint32_t TB_VERSION = 1;
+
+// Runs are (value byte, varint length); values 0..2 (WDL) pack a run into one byte:
+// value in the top 2 bits, length - 1 (up to 64) in the low 6
+static const uint32_t TB_RUNS = 0;
+static const uint32_t TB_PACKED_RUNS = 1;
+
+static void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+static uint64_t getVarint(const uint8_t*& p) {
+    uint64_t v = 0;
+    for (int shift = 0;; shift += 7) {
+        uint8_t byte = *p++;
+        v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return v;
+    }
+}
+
+bool Tablebase::writeFile(const std::string& path, const std::vector<uint8_t>& values) {
+    uint64_t entries = values.size();
+    uint64_t blockCount = (entries + BLOCK_ENTRIES - 1) / BLOCK_ENTRIES;
+
+    bool packed = std::all_of(values.begin(), values.end(), [](uint8_t v) { return v <= 2 || v == TB_ILLEGAL; });
+
+    std::vector<uint64_t> offsets;
+    offsets.reserve(blockCount + 1);
+    std::vector<uint8_t> data;
+
+    // Illegal entries are never probed: extend the current run over them
+    uint8_t previous = TB_DRAW;
+    for (uint64_t block = 0; block < blockCount; block++) {
+        offsets.push_back(data.size());
+        uint64_t end = std::min(entries, (block + 1) * BLOCK_ENTRIES);
+        uint64_t i = block * BLOCK_ENTRIES;
+
+        while (i < end) {
+            uint8_t v = values[i] == TB_ILLEGAL ? previous : values[i];
+            uint64_t run = 0;
+            uint64_t limit = packed ? 64 : UINT64_MAX;
+            while (i < end && run < limit && (values[i] == v || values[i] == TB_ILLEGAL)) { i++; run++; }
+            if (packed) {
+                data.push_back(static_cast<uint8_t>((v << 6) | (run - 1)));
+            } else {
+                data.push_back(v);
+                putVarint(data, run);
+            }
+            previous = v;
+        }
+    }
+    offsets.push_back(data.size());
+
+    TBFileHeader header{};
+    std::memcpy(header.magic, "CETB", 4);
+    header.version = TB_VERSION;
+    header.entries = entries;
+    header.blockEntries = BLOCK_ENTRIES;
+    header.encoding = packed ? TB_PACKED_RUNS : TB_RUNS;
+    header.blockCount = blockCount;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+    out.write(reinterpret_cast<const char*>(data.data()), data.size());
+    return out.good();
+}
+
+bool Tablebase::readFile(const std::string& path, std::vector<uint8_t>& values) {
+    MappedTable t;
+    if (!mapFile(path, t)) return false;
+
+    values.resize(t.entries);
+    uint64_t i = 0;
+    const uint8_t* p = t.data;
+    const uint8_t* end = t.data + t.offsets[t.blockCount];
+    while (p < end && i < t.entries) {
+        uint8_t v;
+        uint64_t run = nextRun(t, p, v);
+        std::fill_n(values.begin() + i, std::min(run, t.entries - i), v);
+        i += run;
+    }
+
+    munmap(const_cast<uint8_t*>(t.base), t.length);
+    return i == t.entries;
+}
+
+bool Tablebase::mapFile(const std::string& path, MappedTable& out) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(TBFileHeader)) {
+        ::close(fd);
+        return false;
+    }
+
+    void* mem = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED) return false;
+
+    const uint8_t* base = static_cast<const uint8_t*>(mem);
+    TBFileHeader header;
+    std::memcpy(&header, base, sizeof(header));
+
+    size_t tableBytes = sizeof(header) + (header.blockCount + 1) * sizeof(uint64_t);
+    if (std::memcmp(header.magic, "CETB", 4) != 0 || header.version != TB_VERSION ||
+        header.blockEntries != BLOCK_ENTRIES || header.encoding > TB_PACKED_RUNS || tableBytes > (size_t)st.st_size) {
+        munmap(mem, st.st_size);
+        return false;
+    }
+
+    out.base = base;
+    out.length = st.st_size;
+    out.entries = header.entries;
+    out.packed = header.encoding == TB_PACKED_RUNS;
+    out.blockCount = header.blockCount;
+    out.offsets = reinterpret_cast<const uint64_t*>(base + sizeof(header));
+    out.data = base + tableBytes;
+    return true;
+}
+
+uint64_t Tablebase::nextRun(const MappedTable& t, const uint8_t*& p, uint8_t& value) {
+    if (t.packed) {
+        uint8_t token = *p++;
+        value = token >> 6;
+        return (token & 0x3F) + 1;
+    }
+    value = *p++;
+    return getVarint(p);
+}
+
+uint8_t Tablebase::lookup(const MappedTable& t, uint64_t index) {
+    if (index >= t.entries) return TB_ILLEGAL;
+
+    const uint8_t* p = t.data + t.offsets[index / BLOCK_ENTRIES];
+    uint64_t pos = index % BLOCK_ENTRIES;
+    for (;;) {
+        uint8_t v;
+        uint64_t run = nextRun(t, p, v);
+        if (pos < run) return v;
+        pos -= run;
+    }
+}
+
+// ----------------------------------------------------------
+// Probing
+// ----------------------------------------------------------
+int Tablebase::open(const std::string& dir) {
+    close();
+
+    std::error_code ec;
+    for (const auto& file : std::filesystem::directory_iterator(dir, ec)) {
+        std::string ext = file.path().extension().string();
+        if (ext != ".wdl" && ext != ".dtm") continue;
+
+        TBMaterial m;
+        if (!parseMaterial(file.path().stem().string(), m)) continue;
+
+        MappedTable t;
+        if (!mapFile(file.path().string(), t)) continue;
+        if (t.entries != m.size) {
+            munmap(const_cast<uint8_t*>(t.base), t.length);
+            continue;
+        }
+
+        (ext == ".wdl" ? wdlTables : dtmTables)[m.name] = t;
+        largest = std::max(largest, m.men());
+    }
+
+    return (int)std::max(wdlTables.size(), dtmTables.size());
+}
+
+void Tablebase::close() {
+    for (auto* tables : {&wdlTables, &dtmTables}) {
+        for (auto& [name, t] : *tables) munmap(const_cast<uint8_t*>(t.base), t.length);
+        tables->clear();
+    }
+    largest = 0;
+}
+
+bool Tablebase::probeWDL(const std::array<int8_t, 64>& board, bool white, int& result) const {
+    std::string name;
+    uint64_t index;
+    if (!locate(board, white, name, index)) {
+        if (!bareKings(board)) return false; // too many pieces or no king: not covered
+        result = 0;
+        return true;
+    }
+
+    auto it = wdlTables.find(name);
+    if (it == wdlTables.end()) return false;
+
+    uint8_t v = lookup(it->second, index);
+    if (v == TB_ILLEGAL) return false;
+    result = v == 1 ? 1 : v == 2 ? -1 : 0;
+    return true;
+}
+
+bool Tablebase::probeDTM(const std::array<int8_t, 64>& board, bool white, int& result, int& plies) const {
+    std::string name;
+    uint64_t index;
+    if (!locate(board, white, name, index)) {
+        if (!bareKings(board)) return false;
+        result = 0;
+        plies = 0;
+        return true;
+    }
+
+    auto it = dtmTables.find(name);
+    if (it == dtmTables.end()) return false;
+
+    uint8_t v = lookup(it->second, index);
+    if (v == TB_ILLEGAL) return false;
+    if (v == TB_DRAW) {
+        result = 0;
+        plies = 0;
+    } else {
+        plies = v - 1;
+        result = (plies & 1) ? 1 : -1;
+    }
+    return true;
+}
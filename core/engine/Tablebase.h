@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// Material of one table. Besides the two kings, `pieces` lists the white pieces then the
+// black ones, each side ordered Q R B N P. The stronger side is always white ("KQvKR",
+// never "KRvKQ"); positions with colors the other way round are probed mirrored.
+struct TBMaterial {
+    std::string name;
+    int8_t pieces[8];
+    int count = 0;          // pieces besides the kings
+    bool hasPawns = false;
+    uint64_t size = 0;      // number of indices
+
+    int men() const { return count + 2; }
+};
+
+// DTM values, one byte per position:
+//   0         draw (or unknown during generation)
+//   1..254    distance to mate in plies + 1: an odd distance wins for the side to move,
+//             an even one loses (1 = checkmated)
+//   255       illegal or duplicate position, never probed
+static const uint8_t TB_DRAW = 0;
+static const uint8_t TB_ILLEGAL = 255;
+
+// Endgame tablebases: indexing shared with TablebaseGenerator, compressed file format,
+// and read-only probing through memory-mapped files.
+//
+// Index of a position: side to move, then the white king square folded by symmetry
+// (10 squares without pawns, 32 with pawns), then black king and the other pieces as raw squares.
+// Files ("KQvKR.wdl", "KQvKR.dtm") are run-length encoded in blocks of BLOCK_ENTRIES
+// entries with a block offset table, so a probe only decodes part of one block.
+class Tablebase {
+
+    struct MappedTable {
+        const uint8_t* base = nullptr;
+        size_t length = 0;
+        uint64_t entries = 0;
+        bool packed = false;    // WDL runs packed into single bytes
+        uint64_t blockCount = 0;
+        const uint64_t* offsets = nullptr;
+        const uint8_t* data = nullptr;
+    };
+
+    std::unordered_map<std::string, MappedTable> wdlTables;
+    std::unordered_map<std::string, MappedTable> dtmTables;
+    int largest = 0;
+
+    static bool mapFile(const std::string& path, MappedTable& out);
+    static uint8_t lookup(const MappedTable& t, uint64_t index);
+
+    // Decodes the run at `p` and advances past it
+    static uint64_t nextRun(const MappedTable& t, const uint8_t*& p, uint8_t& value);
+
+public:
+
+    static const uint32_t BLOCK_ENTRIES = 4096;
+
+    Tablebase() = default;
+    ~Tablebase() { close(); }
+    Tablebase(const Tablebase&) = delete;
+    Tablebase& operator=(const Tablebase&) = delete;
+
+    // ---- Indexing (shared with the generator) ----
+
+    // "KQvKR" -> material, false on a malformed name
+    static bool parseMaterial(const std::string& name, TBMaterial& out);
+
+    // Canonical table name for piece letters of each side, e.g. ("R", "Q") -> "KQvKR" (flipped)
+    static std::string canonicalName(std::string white, std::string black, bool* flipped = nullptr);
+
+    // squares[0] white king, squares[1] black king, squares[2..] in material order.
+    // Returns the smallest index over the board symmetries.
+    static uint64_t encode(const TBMaterial& m, const int* squares, bool white);
+    static void decode(const TBMaterial& m, uint64_t index, int* squares, bool& white);
+
+    // Table name and index of a board position. False with only kings left, more than
+    // 6 pieces besides the kings, or a king missing.
+    static bool locate(const std::array<int8_t, 64>& board, bool white, std::string& name, uint64_t& index);
+
+    static int countMen(const std::array<int8_t, 64>& board);
+
+    // ---- Files ----
+
+    // Compresses `values` (TB_ILLEGAL entries are don't-care) into `path`
+    static bool writeFile(const std::string& path, const std::vector<uint8_t>& values);
+
+    // Decompresses a whole file (generator: finished tables used as children)
+    static bool readFile(const std::string& path, std::vector<uint8_t>& values);
+
+    // ---- Probing ----
+
+    // Maps every table found in `dir`; returns the number of tables available
+    int open(const std::string& dir);
+    void close();
+
+    // Most men of any mapped table, 0 when none are loaded
+    int maxPieces() const { return largest; }
+
+    // Win (1), draw (0) or loss (-1) for the side to move. False if the position has no table.
+    bool probeWDL(const std::array<int8_t, 64>& board, bool white, int& result) const;
+
+    // As probeWDL, plus the distance to mate in plies for a win or a loss
+    bool probeDTM(const std::array<int8_t, 64>& board, bool white, int& result, int& plies) const;
+};
@@ -0,0 +1,492 @@
+#include "TablebaseGenerator.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <set>
+#include <thread>
+
+// ----------------------------------------------------------
+// Move geometry on the raw board
+// ----------------------------------------------------------
+static const int KNIGHT_D[8][2] = {{2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}};
+static const int KING_D[8][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+static const int ROOK_D[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+static const int BISHOP_D[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+static bool onBoard(int r, int c) {
+    return r >= 0 && r < 8 && c >= 0 && c < 8;
+}
+
+// Is `sq` attacked by the pieces of `byWhite`
+static bool attacked(const std::array<int8_t, 64>& board, int sq, bool byWhite) {
+    int r = sq >> 3, c = sq & 7;
+    int sign = byWhite ? 1 : -1;
+
+    // Pawns attack diagonally forward, so look one rank towards their side
+    int pr = byWhite ? r - 1 : r + 1;
+    for (int dc : {-1, 1}) {
+        if (onBoard(pr, c + dc) && board[pr * 8 + c + dc] == sign * 1) return true;
+    }
+    for (auto& d : KNIGHT_D) {
+        if (onBoard(r + d[0], c + d[1]) && board[(r + d[0]) * 8 + c + d[1]] == sign * 4) return true;
+    }
+    for (auto& d : KING_D) {
+        if (onBoard(r + d[0], c + d[1]) && board[(r + d[0]) * 8 + c + d[1]] == sign * 6) return true;
+    }
+    for (int diagonal = 0; diagonal < 2; diagonal++) {
+        for (auto& d : diagonal ? BISHOP_D : ROOK_D) {
+            int slider = diagonal ? 3 : 2;
+            for (int rr = r + d[0], cc = c + d[1]; onBoard(rr, cc); rr += d[0], cc += d[1]) {
+                int8_t p = board[rr * 8 + cc];
+                if (p == 0) continue;
+                if (p == sign * slider || p == sign * 5) return true;
+                break;
+            }
+        }
+    }
+    return false;
+}
+
+// Calls f(from, to) for every target of the piece on `from`: empty squares, plus enemy
+// squares when `captures` is set. Pawns are handled by the callers.
+template <class F>
+static void forEachTarget(const std::array<int8_t, 64>& board, int from, bool captures, F&& f) {
+    int8_t piece = board[from];
+    int type = std::abs(piece);
+    int r = from >> 3, c = from & 7;
+
+    auto visit = [&](int to) {
+        int8_t t = board[to];
+        if (t == 0 || (captures && (t > 0) != (piece > 0) && std::abs(t) != 6)) f(from, to);
+        return t == 0;
+    };
+
+    if (type == 4 || type == 6) {
+        for (auto& d : type == 4 ? KNIGHT_D : KING_D) {
+            if (onBoard(r + d[0], c + d[1])) visit((r + d[0]) * 8 + c + d[1]);
+        }
+        return;
+    }
+    for (int diagonal = 0; diagonal < 2; diagonal++) {
+        if ((diagonal ? type == 2 : type == 3)) continue; // rook: straight only, bishop: diagonal only
+        for (auto& d : diagonal ? BISHOP_D : ROOK_D) {
+            for (int rr = r + d[0], cc = c + d[1]; onBoard(rr, cc); rr += d[0], cc += d[1]) {
+                if (!visit(rr * 8 + cc)) break;
+            }
+        }
+    }
+}
+
+// Pseudo-legal moves of `white`: f(from, to, promotion)
+template <class F>
+static void forEachMove(const std::array<int8_t, 64>& board, bool white, F&& f) {
+    for (int from = 0; from < 64; from++) {
+        int8_t piece = board[from];
+        if (piece == 0 || (piece > 0) != white) continue;
+
+        if (std::abs(piece) != 1) {
+            forEachTarget(board, from, true, [&](int fr, int to) { f(fr, to, false); });
+            continue;
+        }
+
+        int r = from >> 3, c = from & 7;
+        int dir = white ? 1 : -1;
+        int nr = r + dir;
+        bool promotion = nr == (white ? 7 : 0);
+
+        if (board[nr * 8 + c] == 0) {
+            f(from, nr * 8 + c, promotion);
+            bool start = r == (white ? 1 : 6);
+            if (start && board[(nr + dir) * 8 + c] == 0) f(from, (nr + dir) * 8 + c, false);
+        }
+        for (int dc : {-1, 1}) {
+            if (!onBoard(nr, c + dc)) continue;
+            int8_t t = board[nr * 8 + c + dc];
+            if (t != 0 && (t > 0) != white && std::abs(t) != 6) f(from, nr * 8 + c + dc, promotion);
+        }
+    }
+}
+
+// Non-capturing moves `white` could have just played to reach this board,
+// as f(current square, previous square)
+template <class F>
+static void forEachUnmove(const std::array<int8_t, 64>& board, bool white, F&& f) {
+    for (int sq = 0; sq < 64; sq++) {
+        int8_t piece = board[sq];
+        if (piece == 0 || (piece > 0) != white) continue;
+
+        if (std::abs(piece) != 1) {
+            forEachTarget(board, sq, false, f);
+            continue;
+        }
+
+        int r = sq >> 3, c = sq & 7;
+        int dir = white ? -1 : 1; // backwards
+        int pr = r + dir;
+        if (pr == (white ? 0 : 7) || board[pr * 8 + c] != 0) continue; // pawns never stand on the back rank
+        f(sq, pr * 8 + c);
+
+        // Double push from the start rank
+        if (r == (white ? 3 : 4) && board[(pr + dir) * 8 + c] == 0) f(sq, (pr + dir) * 8 + c);
+    }
+}
+
+// ----------------------------------------------------------
+// Parallel loop over [0, n) in chunks
+// ----------------------------------------------------------
+template <class F>
+static void parallelFor(uint64_t n, int threads, F&& body) {
+    const uint64_t CHUNK = 1 << 14;
+    std::atomic<uint64_t> next{0};
+
+    auto worker = [&]() {
+        for (;;) {
+            uint64_t begin = next.fetch_add(CHUNK, std::memory_order_relaxed);
+            if (begin >= n) return;
+            body(begin, std::min(n, begin + CHUNK));
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+}
+
+// ----------------------------------------------------------
+// Material enumeration
+// ----------------------------------------------------------
+TablebaseGenerator::TablebaseGenerator(const std::string& dir, int threads, std::ostream& log)
+    : dir(dir), threads(std::max(1, threads)), log(log) {}
+
+std::vector<std::string> TablebaseGenerator::materials(int maxMen) {
+    // All multisets of piece letters of a given size, strongest first
+    std::vector<std::vector<std::string>> sets(maxMen);
+    sets[0] = {""};
+    for (int k = 1; k < maxMen; k++) {
+        for (const std::string& s : sets[k - 1]) {
+            for (char c : std::string("QRBNP")) {
+                if (!s.empty() && std::string("QRBNP").find(c) < std::string("QRBNP").find(s.back())) continue;
+                sets[k].push_back(s + c);
+            }
+        }
+    }
+
+    std::set<std::string> names;
+    for (int men = 3; men <= maxMen; men++) {
+        int k = men - 2;
+        for (int w = 0; w <= k; w++) {
+            for (const std::string& white : sets[w]) {
+                for (const std::string& black : sets[k - w]) names.insert(Tablebase::canonicalName(white, black));
+            }
+        }
+    }
+
+    std::vector<std::string> ordered(names.begin(), names.end());
+    auto pawns = [](const std::string& n) { return std::count(n.begin(), n.end(), 'P'); };
+    std::sort(ordered.begin(), ordered.end(), [&](const std::string& a, const std::string& b) {
+        if (a.size() != b.size()) return a.size() < b.size(); // men
+        if (pawns(a) != pawns(b)) return pawns(a) < pawns(b);
+        return a < b;
+    });
+    return ordered;
+}
+
+std::vector<std::string> TablebaseGenerator::children(const std::string& name) {
+    size_t v = name.find('v');
+    std::string sides[2] = {name.substr(1, v - 1), name.substr(v + 2)};
+    std::set<std::string> out;
+
+    auto add = [&](const std::string& w, const std::string& b) {
+        if (!w.empty() || !b.empty()) out.insert(Tablebase::canonicalName(w, b));
+    };
+
+    for (int s = 0; s < 2; s++) {
+        std::string& own = sides[s];
+        std::string& opp = sides[1 - s];
+
+        // Capture of an opposing piece, optionally promoting at the same time
+        for (size_t i = 0; i < opp.size(); i++) {
+            std::string rest = opp.substr(0, i) + opp.substr(i + 1);
+            add(s == 0 ? own : rest, s == 0 ? rest : own);
+            for (size_t j = 0; j < own.size(); j++) {
+                if (own[j] != 'P') continue;
+                std::string promoted = own;
+                promoted[j] = 'Q';
+                add(s == 0 ? promoted : rest, s == 0 ? rest : promoted);
+            }
+        }
+        // Quiet promotion
+        for (size_t j = 0; j < own.size(); j++) {
+            if (own[j] != 'P') continue;
+            std::string promoted = own;
+            promoted[j] = 'Q';
+            add(s == 0 ? promoted : opp, s == 0 ? opp : promoted);
+        }
+    }
+
+    return std::vector<std::string>(out.begin(), out.end());
+}
+
+// ----------------------------------------------------------
+// Finished tables used as children
+// ----------------------------------------------------------
+const std::vector<uint8_t>* TablebaseGenerator::child(const std::string& name) {
+    auto it = finished.find(name);
+    if (it != finished.end()) return &it->second;
+
+    std::vector<uint8_t> values;
+    if (!Tablebase::readFile(dir + "/" + name + ".dtm", values)) return nullptr;
+    return &(finished[name] = std::move(values));
+}
+
+uint8_t TablebaseGenerator::probeChild(const std::array<int8_t, 64>& board, bool white) {
+    std::string name;
+    uint64_t index;
+    if (!Tablebase::locate(board, white, name, index)) return TB_DRAW; // bare kings
+
+    // Loaded before the table's generation started, so this is a read-only lookup
+    auto it = finished.find(name);
+    return it != finished.end() ? it->second[index] : TB_DRAW;
+}
+
+// ----------------------------------------------------------
+// Retrograde analysis of one table
+// ----------------------------------------------------------
+static const uint8_t ESCAPE = 0x80; // counter flag: a move reaches a draw, the position can't be lost
+
+void TablebaseGenerator::generate(const TBMaterial& m, std::vector<uint8_t>& values) {
+    const uint64_t size = m.size;
+
+    values.assign(size, TB_DRAW);
+    std::vector<uint8_t> counters(size, 0); // distinct in-table children not yet known to win | ESCAPE
+    std::vector<uint8_t> pending(size, 0);  // distance at which a capture/promotion decides it
+
+    // Places the pieces; false if two share a square or a pawn is on a back rank
+    auto setup = [&](const int* sq, std::array<int8_t, 64>& board) {
+        board.fill(0);
+        board[sq[0]] = 6;
+        if (board[sq[1]] != 0) return false;
+        board[sq[1]] = -6;
+        for (int i = 0; i < m.count; i++) {
+            int s = sq[i + 2];
+            if (board[s] != 0) return false;
+            if (std::abs(m.pieces[i]) == 1 && (s < 8 || s >= 56)) return false;
+            board[s] = m.pieces[i];
+        }
+        return true;
+    };
+
+    // ---- Pass 0: score every position from its own moves ----
+    parallelFor(size, threads, [&](uint64_t begin, uint64_t end) {
+        std::array<int8_t, 64> board;
+        int sq[8];
+        bool white;
+        std::vector<uint64_t> kids;
+
+        for (uint64_t i = begin; i < end; i++) {
+            Tablebase::decode(m, i, sq, white);
+            if (!setup(sq, board) || Tablebase::encode(m, sq, white) != i ||
+                attacked(board, sq[white ? 1 : 0], white)) {
+                values[i] = TB_ILLEGAL;
+                continue;
+            }
+
+            kids.clear();
+            bool escape = false, exits = false;
+            int winAt = 0, lossFloor = 0;
+
+            forEachMove(board, white, [&](int from, int to, bool promotion) {
+                int8_t moved = board[from];
+                int8_t taken = board[to];
+                board[to] = promotion ? (white ? 5 : -5) : moved;
+                board[from] = 0;
+
+                int king = std::abs(moved) == 6 ? to : sq[white ? 0 : 1];
+                if (!attacked(board, king, !white)) {
+                    if (taken == 0 && !promotion) {
+                        int k = 0;
+                        while (sq[k] != from) k++;
+                        sq[k] = to;
+                        kids.push_back(Tablebase::encode(m, sq, !white));
+                        sq[k] = from;
+                    } else {
+                        exits = true;
+                        uint8_t v = probeChild(board, !white);
+                        if (v == TB_DRAW) {
+                            escape = true;
+                        } else if (((v - 1) & 1) == 0) {
+                            // Opponent is mated in v-1 plies: we mate in v
+                            if (winAt == 0 || v < winAt) winAt = v;
+                        } else {
+                            lossFloor = std::max<int>(lossFloor, v);
+                        }
+                    }
+                }
+
+                board[from] = moved;
+                board[to] = taken;
+            });
+
+            // Symmetric children can be reached by several moves: count each once
+            std::sort(kids.begin(), kids.end());
+            int distinct = (int)(std::unique(kids.begin(), kids.end()) - kids.begin());
+
+            if (distinct == 0 && !exits) {
+                bool inCheck = attacked(board, sq[white ? 0 : 1], !white);
+                if (inCheck) values[i] = 1; // checkmated
+                else escape = true;         // stalemate
+            }
+
+            counters[i] = static_cast<uint8_t>(distinct) | (escape ? ESCAPE : 0);
+            if (winAt) pending[i] = static_cast<uint8_t>(winAt);
+            else if (lossFloor && !escape) pending[i] = static_cast<uint8_t>(lossFloor);
+        }
+    });
+
+    int maxPending = 0;
+    for (uint8_t p : pending) maxPending = std::max<int>(maxPending, p);
+
+    // ---- Passes 1..: distance to mate grows one ply per pass ----
+    // Stored value n + 1 = resolved at distance n. Sources of pass n are the positions
+    // resolved at n - 1 (value n); new results get n + 1, so they aren't visited twice.
+    uint64_t previous = 1;
+    for (int n = 1; n <= 253; n++) {
+        std::atomic<uint64_t> resolved{0};
+        bool winPass = n & 1;
+
+        parallelFor(size, threads, [&](uint64_t begin, uint64_t end) {
+            std::array<int8_t, 64> board;
+            int sq[8];
+            bool white;
+            std::vector<uint64_t> preds;
+            uint64_t found = 0;
+
+            auto resolve = [&](uint64_t idx) {
+                uint8_t expected = TB_DRAW;
+                if (std::atomic_ref<uint8_t>(values[idx]).compare_exchange_strong(expected, static_cast<uint8_t>(n + 1),
+                                                                                  std::memory_order_relaxed)) {
+                    found++;
+                }
+            };
+
+            for (uint64_t i = begin; i < end; i++) {
+                uint8_t v = std::atomic_ref<uint8_t>(values[i]).load(std::memory_order_relaxed);
+
+                if (v == TB_DRAW && pending[i] == n) {
+                    // Decided by a capture or promotion (losses only once every in-table move loses)
+                    if (winPass || std::atomic_ref<uint8_t>(counters[i]).load(std::memory_order_relaxed) == 0) resolve(i);
+                    continue;
+                }
+                if (v != n) continue;
+
+                // Predecessors: the side that just moved takes its move back
+                Tablebase::decode(m, i, sq, white);
+                setup(sq, board);
+                preds.clear();
+                forEachUnmove(board, !white, [&](int cur, int prev) {
+                    int k = 0;
+                    while (sq[k] != cur) k++;
+                    sq[k] = prev;
+                    preds.push_back(Tablebase::encode(m, sq, !white));
+                    sq[k] = cur;
+                });
+                std::sort(preds.begin(), preds.end());
+                preds.erase(std::unique(preds.begin(), preds.end()), preds.end());
+
+                for (uint64_t p : preds) {
+                    if (std::atomic_ref<uint8_t>(values[p]).load(std::memory_order_relaxed) != TB_DRAW) continue;
+
+                    if (winPass) {
+                        resolve(p); // a move into a lost position
+                    } else {
+                        // One more move known to lose; the last one decides
+                        uint8_t left = std::atomic_ref<uint8_t>(counters[p]).fetch_sub(1, std::memory_order_relaxed) - 1;
+                        uint8_t floor = pending[p];
+                        if (left == 0 && !(floor & 1) && floor <= n) resolve(p);
+                    }
+                }
+            }
+
+            resolved.fetch_add(found, std::memory_order_relaxed);
+        });
+
+        uint64_t now = resolved.load();
+        if (now == 0 && previous == 0 && n > maxPending) break;
+        previous = now;
+    }
+}
+
+// ----------------------------------------------------------
+// All tables
+// ----------------------------------------------------------
+bool TablebaseGenerator::run(int maxMen) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+
+    std::vector<std::string> names = materials(maxMen);
+
+    // Position of the last table that needs each one as a child, to free memory early
+    std::unordered_map<std::string, size_t> lastUse;
+    for (size_t i = 0; i < names.size(); i++) {
+        for (const std::string& c : children(names[i])) lastUse[c] = i;
+    }
+
+    for (size_t i = 0; i < names.size(); i++) {
+        const std::string& name = names[i];
+        std::string base = dir + "/" + name;
+
+        if (std::filesystem::exists(base + ".dtm") && std::filesystem::exists(base + ".wdl")) {
+            log << name << ": already generated\n";
+            continue;
+        }
+
+        for (const std::string& c : children(name)) {
+            if (!child(c)) {
+                log << name << ": missing child table " << c << "\n";
+                return false;
+            }
+        }
+
+        TBMaterial m;
+        Tablebase::parseMaterial(name, m);
+        auto t0 = std::chrono::steady_clock::now();
+
+        std::vector<uint8_t> values;
+        generate(m, values);
+
+        std::vector<uint8_t> wdl(values.size());
+        uint64_t legal = 0, wins = 0, losses = 0;
+        int longest = 0;
+        for (size_t k = 0; k < values.size(); k++) {
+            uint8_t v = values[k];
+            if (v == TB_ILLEGAL) { wdl[k] = TB_ILLEGAL; continue; }
+            legal++;
+            if (v == TB_DRAW) { wdl[k] = 0; continue; }
+            bool win = (v - 1) & 1;
+            wdl[k] = win ? 1 : 2;
+            (win ? wins : losses)++;
+            longest = std::max(longest, v - 1);
+        }
+
+        if (!Tablebase::writeFile(base + ".dtm", values) || !Tablebase::writeFile(base + ".wdl", wdl)) {
+            log << name << ": failed to write " << base << "\n";
+            return false;
+        }
+
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        log << name << ": " << legal << " positions, " << wins << " won, " << losses << " lost, longest mate "
+            << longest << " plies, " << secs << "s" << std::endl;
+
+        if (lastUse.count(name) && lastUse[name] > i) finished[name] = std::move(values);
+
+        // Drop children no later table needs
+        for (auto it = finished.begin(); it != finished.end();) {
+            if (lastUse[it->first] <= i) it = finished.erase(it);
+            else ++it;
+        }
+    }
+
+    return true;
+}
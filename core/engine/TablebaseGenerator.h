@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Tablebase.h"
+
+// Offline retrograde generator for the tables read by Tablebase.
+//
+// Tables are built smallest first (men, then pawns), so every capture or promotion leads
+// into a finished table. For one table:
+//   1. every position is scored once by generating its moves: checkmates and stalemates are
+//      final, moves leaving the table are resolved from the child table, and moves staying
+//      in the table are counted;
+//   2. distance to mate grows one ply per pass: predecessors of positions lost in n-1 plies
+//      win in n; predecessors of positions won in n-1 plies lose in n once all their moves
+//      are known to lose (counter reaches zero);
+//   3. whatever is left unresolved is a draw.
+// Passes are split over worker threads; shared counters and values use atomic updates.
+// En passant, castling and underpromotion are not modelled (the engine promotes to a queen).
+class TablebaseGenerator {
+
+    std::string dir;
+    int threads;
+    std::ostream& log;
+
+    // DTM values of finished tables still needed as children
+    std::unordered_map<std::string, std::vector<uint8_t>> finished;
+
+    // Child table values, loading it from disk if needed
+    const std::vector<uint8_t>* child(const std::string& name);
+
+    // Value of a position after a capture or promotion, from the child's side to move
+    uint8_t probeChild(const std::array<int8_t, 64>& board, bool white);
+
+    void generate(const TBMaterial& m, std::vector<uint8_t>& values);
+
+    // Tables reached from `name` by one capture or promotion
+    static std::vector<std::string> children(const std::string& name);
+
+public:
+
+    TablebaseGenerator(const std::string& dir, int threads, std::ostream& log = std::cout);
+
+    // All tables up to `maxMen` men, in generation order
+    static std::vector<std::string> materials(int maxMen);
+
+    // Generates every missing table up to `maxMen` men into the directory
+    bool run(int maxMen);
+};
@@ -0,0 +1,167 @@
+#include "Trace.h"
+#include "../Utils.h"
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <pthread.h>
+#include <thread>
+
+std::atomic<bool> Trace::active{false};
+
+struct TraceEvent {
+    const char* name;
+    const char* category;
+    int64_t start;      // ns since Trace::start()
+    int64_t duration;   // ns
+    const char* argName;
+    long long arg;
+    int move;           // from | to << 6, -1 = none
+};
+
+// One thread's events. Only the owner appends; stop() reads the first `count` events,
+// which the owner publishes with a release store after writing them.
+struct ThreadBuffer {
+    int tid = 0;
+    std::atomic<const char*> name{nullptr};
+    std::unique_ptr<TraceEvent[]> events{new TraceEvent[Trace::CAPACITY]};
+    std::atomic<int> count{0};
+    std::atomic<long long> dropped{0};
+    unsigned calls = 0; // sampling counter
+    std::atomic<bool> inUse{true};
+    ThreadBuffer* next = nullptr;
+};
+
+// Buffers are never freed, only recycled: detached threads may still hold theirs when the
+// trace is written, and stop() walks every buffer, held or free
+static std::atomic<ThreadBuffer*> buffers{nullptr};
+static std::atomic<int> nextTid{1};
+
+// Gives the thread's buffer back when the thread exits
+struct LocalBuffer {
+    ThreadBuffer* buffer = nullptr;
+
+    ~LocalBuffer() {
+        if (buffer) buffer->inUse.store(false, std::memory_order_release);
+    }
+};
+
+static thread_local LocalBuffer local;
+
+static std::string tracePath;
+static std::chrono::steady_clock::time_point origin;
+
+static ThreadBuffer* localBuffer() {
+    if (local.buffer) return local.buffer;
+
+    // A buffer left by a finished thread: its track continues with this thread's events
+    for (ThreadBuffer* b = buffers.load(); b; b = b->next) {
+        bool used = false;
+        if (b->inUse.compare_exchange_strong(used, true, std::memory_order_acquire)) {
+            return local.buffer = b;
+        }
+    }
+
+    ThreadBuffer* b = new ThreadBuffer();
+    b->tid = nextTid.fetch_add(1);
+    b->next = buffers.load();
+    while (!buffers.compare_exchange_weak(b->next, b)) {}
+    return local.buffer = b;
+}
+
+void Trace::start(const std::string& path) {
+    tracePath = path;
+    origin = std::chrono::steady_clock::now();
+    active.store(true);
+    threadName("main");
+
+    // Daemons and workers usually end on a signal: write the trace then as well.
+    // Threads created from here on inherit the mask; one thread waits for the signals.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    std::thread([signals] {
+        int sig = 0;
+        sigwait(&signals, &sig);
+        Trace::stop();
+        std::_Exit(128 + sig);
+    }).detach();
+
+    std::atexit(Trace::stop);
+}
+
+int64_t Trace::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void Trace::complete(const char* name, const char* category, int64_t started,
+                     const char* argName, long long arg, const Gen* move) {
+    if (!enabled()) return;
+    ThreadBuffer* b = localBuffer();
+    int n = b->count.load(std::memory_order_relaxed);
+    if (n >= CAPACITY) {
+        b->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    b->events[n] = {name, category, started, now() - started, argName, arg,
+                    move ? move->from | move->to << 6 : -1};
+    b->count.store(n + 1, std::memory_order_release);
+}
+
+void Trace::threadName(const char* name) {
+    if (enabled()) localBuffer()->name.store(name, std::memory_order_release);
+}
+
+bool Trace::sample() {
+    return ++localBuffer()->calls % SAMPLE_RATE == 0;
+}
+
+// ----------------------------------------------------------
+// Output: {"traceEvents": [...]}, timestamps in microseconds
+// ----------------------------------------------------------
+void Trace::stop() {
+    if (!active.exchange(false)) return;
+
+    FILE* f = std::fopen(tracePath.c_str(), "w");
+    if (!f) {
+        std::cerr << "cannot write trace " << tracePath << "\n";
+        return;
+    }
+
+    std::fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    std::fprintf(f, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"ChessEngine\"}}");
+
+    long long dropped = 0;
+    for (ThreadBuffer* b = buffers.load(); b; b = b->next) {
+        const char* name = b->name.load(std::memory_order_acquire);
+        std::fprintf(f, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"%s %d\"}}",
+                     b->tid, name ? name : "thread", b->tid);
+
+        int count = b->count.load(std::memory_order_acquire);
+        for (int i = 0; i < count; i++) {
+            const TraceEvent& e = b->events[i];
+            std::fprintf(f, ",\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, "
+                            "\"ts\": %.3f, \"dur\": %.3f, \"args\": {",
+                         e.name, e.category, b->tid, e.start / 1000.0, e.duration / 1000.0);
+            bool first = true;
+            if (e.argName) {
+                std::fprintf(f, "\"%s\": %lld", e.argName, e.arg);
+                first = false;
+            }
+            if (e.move >= 0) {
+                std::string move = indexToAlgebraic(e.move & 63) + indexToAlgebraic(e.move >> 6);
+                std::fprintf(f, "%s\"move\": \"%s\"", first ? "" : ", ", move.c_str());
+            }
+            std::fprintf(f, "}}");
+        }
+        dropped += b->dropped.load();
+    }
+
+    std::fprintf(f, "\n]}\n");
+    std::fclose(f);
+    if (dropped > 0) std::cerr << "trace: " << dropped << " events dropped (buffers full)\n";
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "../board/Generate.h"
+
+// Search timeline recording in the Chrome trace-event format (chrome://tracing, Perfetto).
+// Off unless the CHESS_TRACE environment variable names an output file (see main.cpp).
+//
+// Every thread appends to its own fixed-size buffer without locking; the buffers are
+// written out as one JSON file by stop(), at exit or on SIGINT/SIGTERM. A thread that
+// exits hands its buffer to the next new thread, so short-lived search threads share
+// tracks and memory stays at one buffer per live thread. Events past a buffer's
+// capacity are dropped (and counted). While tracing is off each probe costs
+// one relaxed atomic load.
+class Trace {
+
+    static std::atomic<bool> active;
+
+public:
+
+    // Hot functions are timed on one call in SAMPLE_RATE per thread
+    static const int SAMPLE_RATE = 1024;
+
+    // Events kept per buffer
+    static const int CAPACITY = 1 << 17;
+
+    static bool enabled() { return active.load(std::memory_order_relaxed); }
+
+    // Starts recording; the trace goes to `path`
+    static void start(const std::string& path);
+
+    // Writes the trace file and stops recording (no-op when not recording)
+    static void stop();
+
+    // Nanoseconds since start()
+    static int64_t now();
+
+    // Records a span of the calling thread from `started` (a now() value) until now.
+    // Names must be string literals; `arg` is shown as `argName` and `move` as "move".
+    static void complete(const char* name, const char* category, int64_t started,
+                         const char* argName = nullptr, long long arg = 0, const Gen* move = nullptr);
+
+    // Labels the calling thread's track (string literal)
+    static void threadName(const char* name);
+
+    // True on every SAMPLE_RATE-th call from the calling thread
+    static bool sample();
+};
+
+// Records its own lifetime as a span
+class TraceSpan {
+
+    const char* name;
+    const char* category;
+    const char* argName;
+    long long arg;
+    int64_t started;
+
+public:
+
+    TraceSpan(const char* name, const char* category, const char* argName = nullptr, long long arg = 0)
+        : name(name), category(category), argName(argName), arg(arg),
+          started(Trace::enabled() ? Trace::now() : -1) {}
+    ~TraceSpan() { if (started >= 0) Trace::complete(name, category, started, argName, arg); }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+// Times one call in Trace::SAMPLE_RATE of a hot function
+class TraceSample {
+
+    const char* name;
+    int64_t started = -1;
+
+public:
+
+    explicit TraceSample(const char* name) : name(name) {
+        if (Trace::enabled() && Trace::sample()) started = Trace::now();
+    }
+    ~TraceSample() { if (started >= 0) Trace::complete(name, "sampled", started); }
+
+    TraceSample(const TraceSample&) = delete;
+    TraceSample& operator=(const TraceSample&) = delete;
+};
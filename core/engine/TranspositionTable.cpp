@@ -0,0 +1,205 @@
+#include "TranspositionTable.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Start of a shared segment; the slots follow at SHARED_HEADER_BYTES.
+// `ready` is set last by the creator, once the header is filled in.
+struct SharedHeader {
+    std::atomic<uint64_t> ready;
+    uint64_t magic;
+    uint64_t slotSize;
+    uint64_t slotCount;
+};
+
+static const uint64_t SHARED_MAGIC = 0x4348455353545431ULL; // "CHESSTT1"
+static const size_t SHARED_HEADER_BYTES = 64;
+
+// Largest power of two number of slots that fits in `bytes`
+template <typename Slot>
+static size_t slotsFor(size_t bytes) {
+    size_t count = 1;
+    while (count * 2 * sizeof(Slot) <= bytes) count *= 2;
+    return count;
+}
+
+TranspositionTable::TranspositionTable(size_t megabytes) {
+    resize(megabytes);
+}
+
+TranspositionTable::~TranspositionTable() {
+    release();
+}
+
+void TranspositionTable::release() {
+    if (mapped) munmap(mapped, mappedBytes);
+    mapped = nullptr;
+    mappedBytes = 0;
+    owned.reset();
+    slots = nullptr;
+    slotCount = 0;
+}
+
+void TranspositionTable::resize(size_t megabytes) {
+    if (megabytes == 0) megabytes = 1;
+
+    // Round down to a power of two so the index is a mask
+    size_t count = slotsFor<Slot>(megabytes * 1024 * 1024);
+
+    release();
+    owned = std::make_unique<Slot[]>(count);
+    slots = owned.get();
+    slotCount = count;
+}
+
+// ----------------------------------------------------------
+// Shared-memory backing
+// ----------------------------------------------------------
+bool TranspositionTable::attachShared(const std::string& name, size_t megabytes) {
+    if (megabytes == 0) megabytes = 1;
+
+    // The first process creates and sizes the segment; later ones map what is there
+    bool creator = true;
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        creator = false;
+        fd = shm_open(name.c_str(), O_RDWR, 0600);
+    }
+    if (fd < 0) return false;
+
+    size_t bytes = 0;
+    if (creator) {
+        bytes = SHARED_HEADER_BYTES + slotsFor<Slot>(megabytes * 1024 * 1024) * sizeof(Slot);
+        if (ftruncate(fd, (off_t)bytes) < 0) {
+            close(fd);
+            shm_unlink(name.c_str());
+            return false;
+        }
+    } else {
+        // The creator may still be sizing it
+        struct stat st{};
+        for (int tries = 0; tries < 100; tries++) {
+            if (fstat(fd, &st) < 0) break;
+            if (st.st_size > 0) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        bytes = (size_t)st.st_size;
+    }
+
+    void* base = bytes > SHARED_HEADER_BYTES ? mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (base == MAP_FAILED) return false;
+
+    // Fresh pages are zero: every slot starts empty
+    SharedHeader* header = static_cast<SharedHeader*>(base);
+    if (creator) {
+        header->magic = SHARED_MAGIC;
+        header->slotSize = sizeof(Slot);
+        header->slotCount = (bytes - SHARED_HEADER_BYTES) / sizeof(Slot);
+        header->ready.store(1, std::memory_order_release);
+    } else {
+        for (int tries = 0; tries < 100 && header->ready.load(std::memory_order_acquire) == 0; tries++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    // Refuse segments written by another layout
+    bool valid = header->ready.load(std::memory_order_acquire) == 1 && header->magic == SHARED_MAGIC
+        && header->slotSize == sizeof(Slot) && header->slotCount > 0
+        && (header->slotCount & (header->slotCount - 1)) == 0
+        && SHARED_HEADER_BYTES + header->slotCount * sizeof(Slot) <= bytes;
+    if (!valid) {
+        munmap(base, bytes);
+        return false;
+    }
+
+    size_t count = header->slotCount;
+    release();
+    mapped = base;
+    mappedBytes = bytes;
+    slots = reinterpret_cast<Slot*>(static_cast<char*>(base) + SHARED_HEADER_BYTES);
+    slotCount = count;
+    return true;
+}
+
+bool TranspositionTable::attachSharedFromEnvironment() {
+    const char* name = std::getenv("CHESS_SHARED_HASH");
+    if (!name || !*name) return false;
+
+    const char* mb = std::getenv("CHESS_SHARED_HASH_MB");
+    return attachShared(name, mb ? std::strtoul(mb, nullptr, 10) : 256);
+}
+
+void TranspositionTable::clear() {
+    if (mapped) return;
+    for (size_t i = 0; i < slotCount; i++) {
+        slots[i].check.store(0, std::memory_order_relaxed);
+        slots[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+// ----------------------------------------------------------
+// Entry layout: score 32 | depth 8 | flag 2 | from 7 | to 7
+// ----------------------------------------------------------
+uint64_t TranspositionTable::pack(int score, int depth, TTFlag flag, int from, int to) {
+    uint64_t data = static_cast<uint32_t>(score);
+    data |= static_cast<uint64_t>(static_cast<uint8_t>(depth)) << 32;
+    data |= static_cast<uint64_t>(flag) << 40;
+    data |= static_cast<uint64_t>((from + 1) & 0x7F) << 42;
+    data |= static_cast<uint64_t>((to + 1) & 0x7F) << 49;
+    return data;
+}
+
+TTEntry TranspositionTable::unpack(uint64_t data) {
+    TTEntry e;
+    e.score = static_cast<int32_t>(data & 0xFFFFFFFF);
+    e.depth = static_cast<int8_t>((data >> 32) & 0xFF);
+    e.flag  = static_cast<TTFlag>((data >> 40) & 0x3);
+    e.from  = static_cast<int>((data >> 42) & 0x7F) - 1;
+    e.to    = static_cast<int>((data >> 49) & 0x7F) - 1;
+    return e;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& out) const {
+    const Slot& slot = slots[key & (slotCount - 1)];
+
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    uint64_t check = slot.check.load(std::memory_order_relaxed);
+
+    if (data == 0 || (check ^ data) != key) return false;
+
+    out = unpack(data);
+    return true;
+}
+
+void TranspositionTable::store(uint64_t key, int depth, int score, TTFlag flag, int from, int to) {
+    Slot& slot = slots[key & (slotCount - 1)];
+
+    // Keep a deeper result for the same position unless this one is exact
+    uint64_t oldData = slot.data.load(std::memory_order_relaxed);
+    uint64_t oldCheck = slot.check.load(std::memory_order_relaxed);
+    if (oldData != 0 && (oldCheck ^ oldData) == key && flag != TTFlag::EXACT) {
+        TTEntry old = unpack(oldData);
+        if (old.depth > depth) return;
+        // Don't lose the best move on a fail-low re-store
+        if (from < 0) { from = old.from; to = old.to; }
+    }
+
+    uint64_t data = pack(score, depth, flag, from, to);
+    slot.data.store(data, std::memory_order_relaxed);
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull() const {
+    size_t sample = slotCount < 1000 ? slotCount : 1000;
+    int used = 0;
+    for (size_t i = 0; i < sample; i++) {
+        if (slots[i].data.load(std::memory_order_relaxed) != 0) used++;
+    }
+    return sample ? static_cast<int>(used * 1000 / sample) : 0;
+}
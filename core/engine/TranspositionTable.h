@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// Bound type of a stored score
+enum class TTFlag : uint8_t { NONE, EXACT, LOWER, UPPER };
+
+struct TTEntry {
+    int score = 0;
+    int depth = 0;
+    TTFlag flag = TTFlag::NONE;
+    int from = -1;  // best move, -1 if none
+    int to = -1;
+};
+
+// Shared hash table of search results.
+// Each slot stores (key ^ data, data) so a torn write from another thread
+// fails verification instead of returning a corrupted entry.
+//
+// The slots normally live on the heap. attachShared() moves them into a named POSIX
+// shared-memory segment instead, so every engine process on the host that attaches to
+// the same name reads and writes one table; the same verification covers writers in
+// other processes (Zobrist keys are fixed, so they agree on every key).
+class TranspositionTable {
+
+    struct Slot {
+        std::atomic<uint64_t> check{0};
+        std::atomic<uint64_t> data{0};
+    };
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "slots must be lock-free to live in shared memory");
+
+    Slot* slots = nullptr;
+    size_t slotCount = 0;
+
+    std::unique_ptr<Slot[]> owned;   // private table
+    void* mapped = nullptr;          // shared segment (header + slots), if attached
+    size_t mappedBytes = 0;
+
+    void release();
+
+    static uint64_t pack(int score, int depth, TTFlag flag, int from, int to);
+    static TTEntry unpack(uint64_t data);
+
+public:
+
+    explicit TranspositionTable(size_t megabytes = 16);
+    ~TranspositionTable();
+
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    // Private table of the given size (detaches from a shared segment)
+    void resize(size_t megabytes);
+
+    // Clears a private table; a shared one is left alone, other processes rely on it
+    void clear();
+
+    // Attaches to shared-memory segment `name` ("/chess-tt"), creating it with `megabytes`
+    // if it doesn't exist yet; an existing segment keeps its size. False, with the
+    // current table kept, if the segment can't be used.
+    bool attachShared(const std::string& name, size_t megabytes);
+
+    // attachShared() on $CHESS_SHARED_HASH, sized by $CHESS_SHARED_HASH_MB (default 256),
+    // when the variable is set
+    bool attachSharedFromEnvironment();
+
+    bool isShared() const { return mapped != nullptr; }
+
+    bool probe(uint64_t key, TTEntry& out) const;
+    void store(uint64_t key, int depth, int score, TTFlag flag, int from, int to);
+
+    // Permill of sampled slots in use (UCI "hashfull")
+    int hashfull() const;
+};
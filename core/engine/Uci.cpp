@@ -0,0 +1,317 @@
+#include "Uci.h"
+#include "Trace.h"
+#include "../Utils.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+// Time kept back per move for GUI and process latency
+static const int MOVE_OVERHEAD_MS = 30;
+
+static const int MAX_HASH_MB = 16384;
+static const int MAX_THREADS = 256;
+static const int MAX_MULTIPV = 64;
+
+static std::string moveToUci(const Gen& move) {
+    return indexToAlgebraic(move.from) + indexToAlgebraic(move.to) + (move.promotion ? "q" : "");
+}
+
+Uci::Uci() {
+    tt.attachSharedFromEnvironment();
+
+    const char* dir = std::getenv("CHESS_TABLEBASES");
+    if (tablebase.open(dir ? dir : "tablebases") > 0) {
+        s.setTablebase(&tablebase);
+    }
+}
+
+void Uci::send(const std::string& line) {
+    std::lock_guard<std::mutex> lock(outputMutex);
+    std::cout << line << std::endl;
+}
+
+// ----------------------------------------------------------
+// Command loop
+// ----------------------------------------------------------
+int Uci::run() {
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::istringstream in(line);
+        std::string cmd;
+        in >> cmd;
+
+        if (cmd == "uci") {
+            send("id name ChessEngine");
+            send("id author ChessEngine developers");
+            send("option name Hash type spin default 16 min 1 max " + std::to_string(MAX_HASH_MB));
+            send("option name Threads type spin default 1 min 1 max " + std::to_string(MAX_THREADS));
+            send("option name MultiPV type spin default 1 min 1 max " + std::to_string(MAX_MULTIPV));
+            send("option name Ponder type check default false");
+            send("option name Clear Hash type button");
+            send("uciok");
+        }
+        else if (cmd == "isready") {
+            send("readyok");
+        }
+        else if (cmd == "ucinewgame") {
+            stopSearch();
+            tt.clear();
+            s.clearHistory();
+            for (auto& h : helpers) h->s.clearHistory();
+            b = Board();
+        }
+        else if (cmd == "position") {
+            position(in);
+        }
+        else if (cmd == "go") {
+            go(in);
+        }
+        else if (cmd == "stop") {
+            stopSearch();
+        }
+        else if (cmd == "ponderhit") {
+            // The expected move was played: our clock runs from now
+            limits.ponder = false;
+            startClock();
+            {
+                std::lock_guard<std::mutex> lock(holdMutex);
+                holdBestmove = limits.infinite;
+            }
+            holdReleased.notify_all();
+        }
+        else if (cmd == "setoption") {
+            setOption(in);
+        }
+        else if (cmd == "quit") {
+            break;
+        }
+    }
+
+    stopSearch();
+    return 0;
+}
+
+// ----------------------------------------------------------
+// position [startpos | fen <fen>] [moves <m1> <m2> ...]
+// ----------------------------------------------------------
+void Uci::position(std::istringstream& in) {
+    stopSearch();
+
+    std::string spec, error;
+    std::getline(in >> std::ws, spec);
+    if (!setupPosition(b, spec, error)) send("info string " + error);
+}
+
+// ----------------------------------------------------------
+// setoption name <id> [value <x>]
+// ----------------------------------------------------------
+void Uci::setOption(std::istringstream& in) {
+    std::string token, name, value;
+    in >> token; // "name"
+    while (in >> token && token != "value") name += (name.empty() ? "" : " ") + token;
+    std::getline(in >> std::ws, value);
+
+    stopSearch();
+
+    if (name == "Hash") {
+        // A shared table keeps the size it was created with
+        if (!tt.isShared()) tt.resize(std::clamp(std::atoi(value.c_str()), 1, MAX_HASH_MB));
+    } else if (name == "Threads") {
+        threads = std::clamp(std::atoi(value.c_str()), 1, MAX_THREADS);
+        helpers.clear();
+        for (int i = 1; i < threads; i++) {
+            helpers.push_back(std::make_unique<Helper>(tt));
+            if (tablebase.maxPieces() > 0) helpers.back()->s.setTablebase(&tablebase);
+        }
+    } else if (name == "MultiPV") {
+        multiPV = std::clamp(std::atoi(value.c_str()), 1, MAX_MULTIPV);
+    } else if (name == "Clear Hash") {
+        tt.clear();
+    }
+}
+
+// ----------------------------------------------------------
+// go: parse limits, budget the time, start the worker
+// ----------------------------------------------------------
+void Uci::go(std::istringstream& in) {
+    stopSearch();
+
+    limits = GoLimits{};
+    std::string token;
+    while (in >> token) {
+        if (token == "depth") in >> limits.depth;
+        else if (token == "nodes") in >> limits.nodes;
+        else if (token == "movetime") in >> limits.movetime;
+        else if (token == "wtime") in >> limits.time[0];
+        else if (token == "btime") in >> limits.time[1];
+        else if (token == "winc") in >> limits.inc[0];
+        else if (token == "binc") in >> limits.inc[1];
+        else if (token == "movestogo") in >> limits.movestogo;
+        else if (token == "infinite") limits.infinite = true;
+        else if (token == "ponder") limits.ponder = true;
+    }
+
+    // Clock: aim for an even share of the remaining time (plus most of the increment),
+    // never more than a few times that or half of what is left
+    int side = b.getTurn() ? 0 : 1;
+    optimumMs = maximumMs = 0;
+    if (limits.movetime > 0) {
+        maximumMs = std::max(1, limits.movetime - MOVE_OVERHEAD_MS);
+    } else if (limits.time[side] > 0) {
+        int reserve = std::max(1, limits.time[side] - MOVE_OVERHEAD_MS);
+        int movesToGo = limits.movestogo > 0 ? std::min(limits.movestogo, 50) : 30;
+        int share = limits.time[side] / movesToGo + limits.inc[side] * 3 / 4;
+
+        maximumMs = std::min(share * 3, movesToGo > 1 ? reserve / 2 : reserve);
+        optimumMs = std::min(share, maximumMs);
+        maximumMs = std::max(maximumMs, 1);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(holdMutex);
+        holdBestmove = limits.infinite || limits.ponder;
+    }
+
+    s.clearStop();
+    s.setNodeLimit(limits.nodes);
+    s.clearDeadline();
+    softDeadline.store(0);
+    started = std::chrono::steady_clock::now();
+    if (!limits.infinite && !limits.ponder) startClock();
+
+    worker = std::thread(&Uci::think, this);
+}
+
+void Uci::startClock() {
+    auto now = std::chrono::steady_clock::now();
+
+    if (maximumMs > 0) s.setDeadline(now + std::chrono::milliseconds(maximumMs));
+    else s.clearDeadline();
+
+    // Past half the optimum the next iteration most likely won't finish in time
+    softDeadline.store(optimumMs > 0 ? (now + std::chrono::milliseconds(optimumMs / 2)).time_since_epoch().count() : 0);
+}
+
+void Uci::stopSearch() {
+    if (!worker.joinable()) return;
+
+    s.stop();
+    {
+        std::lock_guard<std::mutex> lock(holdMutex);
+        holdBestmove = false;
+    }
+    holdReleased.notify_all();
+    worker.join();
+}
+
+// ----------------------------------------------------------
+// Search thread
+// ----------------------------------------------------------
+long long Uci::totalNodes() const {
+    long long nodes = s.getNodesSearched();
+    for (const auto& h : helpers) nodes += h->s.getNodesPublished();
+    return nodes;
+}
+
+void Uci::sendInfo(int depth, int score, const std::vector<Gen>& pv, int lineNumber) {
+    long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count();
+    long long nodes = totalNodes();
+
+    std::ostringstream out;
+    out << "info depth " << depth << " seldepth " << std::max(s.getSelDepth(), depth);
+    if (lineNumber > 0) out << " multipv " << lineNumber;
+
+    int mate = Search::mateDistance(score);
+    if (mate != 0) out << " score mate " << mate;
+    else out << " score cp " << score;
+
+    out << " nodes " << nodes << " nps " << nodes * 1000 / std::max(ms, 1LL)
+        << " hashfull " << tt.hashfull() << " time " << ms << " pv";
+    for (const Gen& move : pv) out << " " << moveToUci(move);
+    send(out.str());
+}
+
+void Uci::think() {
+    Trace::threadName("uci search");
+    bool white = b.getTurn();
+    std::array<int8_t, 64> root = b.getBoard();
+    int maxDepth = limits.depth > 0 ? std::min(limits.depth, MAX_DEPTH) : MAX_DEPTH;
+
+    auto softLimitReached = [&] {
+        int64_t soft = softDeadline.load();
+        return soft != 0 && std::chrono::steady_clock::now().time_since_epoch().count() >= soft;
+    };
+
+    // Lazy SMP: helpers fill the shared table; odd ones aim a ply deeper so the threads diverge.
+    // A node budget is kept by the main search alone: helpers would search past it.
+    for (auto& h : helpers) h->s.resetStats();
+    size_t helperCount = limits.nodes > 0 ? 0 : helpers.size();
+    std::vector<std::thread> helperThreads;
+    for (size_t i = 0; i < helperCount; i++) {
+        Helper& h = *helpers[i];
+        h.board = b;
+        h.s.clearStop();
+        int depth = maxDepth + (int)(i % 2);
+        helperThreads.emplace_back([&h, root, white, depth] {
+            Trace::threadName("smp helper");
+            h.s.search(root, depth, white, -2000000, 2000000);
+        });
+    }
+
+    std::vector<Gen> best;
+    if (multiPV == 1) {
+        s.setIterationCallback([&](int depth, int score, const std::vector<Gen>& pv) {
+            best = pv;
+            sendInfo(depth, score, pv, 0);
+            return !softLimitReached();
+        });
+
+        std::vector<Gen> pv;
+        int score = s.searchPV(root, maxDepth, white, -2000000, 2000000, pv);
+        s.setIterationCallback(nullptr);
+
+        // Tablebase roots are answered without iterating
+        if (best.empty() && !pv.empty()) {
+            best = pv;
+            sendInfo(1, score, pv, 0);
+        }
+    } else {
+        // getTopMoves searches the replies at least one ply deep: depths 1 and 2 are the same search
+        s.resetStats();
+        for (int d = std::min(2, maxDepth); d <= maxDepth; d++) {
+            std::vector<ScoredMove> lines = s.getTopMoves(root, d, white, multiPV);
+
+            // An interrupted iteration only counts if nothing better exists
+            if (lines.empty() || (s.isStopped() && !best.empty())) break;
+
+            best = lines[0].line;
+            for (size_t k = 0; k < lines.size(); k++) {
+                sendInfo(d, white ? lines[k].score : -lines[k].score, lines[k].line, (int)k + 1);
+            }
+            if (s.isStopped() || softLimitReached()) break;
+        }
+    }
+
+    for (auto& h : helpers) h->s.stop();
+    for (auto& t : helperThreads) t.join();
+
+    // Infinite and ponder searches report only once released
+    {
+        std::unique_lock<std::mutex> lock(holdMutex);
+        holdReleased.wait(lock, [&] { return !holdBestmove; });
+    }
+
+    // Stopped before the first iteration completed: any legal move
+    if (best.empty()) {
+        for (Gen& move : g.generate(root, white)) {
+            if (g.makeMove(root, white, move).has_value()) {
+                best.push_back(move);
+                break;
+            }
+        }
+    }
+
+    std::string line = "bestmove " + (best.empty() ? std::string("0000") : moveToUci(best[0]));
+    if (best.size() > 1) line += " ponder " + moveToUci(best[1]);
+    send(line);
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../board/Board.h"
+#include "../board/Generate.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+#include "Tablebase.h"
+
+// Limits of one "go" command; times in milliseconds, 0 = not given
+struct GoLimits {
+    int depth = 0;
+    long long nodes = 0;
+    int movetime = 0;
+    int time[2] = {0, 0};   // [white, black] clock
+    int inc[2] = {0, 0};
+    int movestogo = 0;
+    bool infinite = false;
+    bool ponder = false;
+};
+
+// UCI front-end (--uci), for GUIs and tournament managers.
+//
+// Commands are read on the main thread; "go" searches on a worker thread so "stop" and
+// "ponderhit" are handled while it runs. Info lines come from completed iterations.
+// Threads > 1 runs helper searches on copies of the position that share the
+// transposition table (lazy SMP); only the main search's result is played.
+class Uci {
+
+    // Helper search with its own board, move generator and histories
+    struct Helper {
+        Board board;
+        Generate g{board};
+        Search s;
+        explicit Helper(TranspositionTable& tt) : s(board, g, tt) {}
+    };
+
+    Board b;
+    Generate g{b};
+    TranspositionTable tt;
+    Tablebase tablebase;
+    Search s{b, g, tt};
+    std::vector<std::unique_ptr<Helper>> helpers;
+
+    // Options
+    int threads = 1;
+    int multiPV = 1;
+
+    std::thread worker;
+    std::mutex outputMutex;
+
+    // Infinite and ponder searches hold their bestmove until "stop" / "ponderhit"
+    std::mutex holdMutex;
+    std::condition_variable holdReleased;
+    bool holdBestmove = false;
+
+    // Time control of the running search
+    GoLimits limits;
+    std::chrono::steady_clock::time_point started;
+    std::atomic<int64_t> softDeadline{0}; // no new iteration after this (steady ticks, 0 = none)
+    int optimumMs = 0;
+    int maximumMs = 0;
+
+    void send(const std::string& line);
+
+    void position(std::istringstream& in);
+    void go(std::istringstream& in);
+    void setOption(std::istringstream& in);
+
+    // Worker: searches the current position and reports bestmove
+    void think();
+
+    // Stops the running search (if any) and waits for its bestmove
+    void stopSearch();
+
+    // Moves the deadlines to start now (go, or ponderhit)
+    void startClock();
+
+    void sendInfo(int depth, int score, const std::vector<Gen>& pv, int lineNumber);
+
+    long long totalNodes() const;
+
+public:
+
+    static const int MAX_DEPTH = 64;
+
+    Uci();
+    ~Uci() { stopSearch(); }
+
+    Uci(const Uci&) = delete;
+    Uci& operator=(const Uci&) = delete;
+
+    int run();
+};
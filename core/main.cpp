@@ -1,20 +1,148 @@
 #include "Utils.h"
 #include "board/Board.h"
 #include "engine/Shell.h"
+#include "engine/TablebaseGenerator.h"
+#include "engine/BookBuilder.h"
+#include "engine/Uci.h"
+#include "engine/Daemon.h"
+#include "engine/Coordinator.h"
+#include "engine/Bench.h"
+#include "engine/Trace.h"
+#include <algorithm>
+#include <iomanip>
 #include <iostream>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
 
 int main(int argc, char* argv[]) {
 
+    // CHESS_TRACE=<file>: record a Chrome trace-event timeline of every mode (see Trace.h)
+    if (const char* tracePath = std::getenv("CHESS_TRACE")) Trace::start(tracePath);
+
     bool api = false;
+    bool binary = false;
     if (argc > 1 && std::string(argv[1]) == "--api") {
         api = true;
+        // Length-prefixed binary frames instead of JSON lines (see ApiWriter.h)
+        binary = argc > 2 && std::string(argv[2]) == "--binary";
+    }
+
+    // UCI protocol for GUIs and tournament managers
+    if (argc > 1 && std::string(argv[1]) == "--uci") {
+        Uci uci;
+        return uci.run();
+    }
+
+    // Multi-session daemon: --daemon <socket> [workers] [max sessions] [hash MB]
+    if (argc > 1 && std::string(argv[1]) == "--daemon") {
+        if (argc < 3) {
+            std::cerr << "usage: --daemon <socket> [workers] [max sessions] [hash MB]\n";
+            return 1;
+        }
+        int workers = argc > 3 ? std::atoi(argv[3]) : (int)std::thread::hardware_concurrency();
+        int maxSessions = argc > 4 ? std::atoi(argv[4]) : 256;
+        int hashMB = argc > 5 ? std::atoi(argv[5]) : 256;
+
+        Daemon daemon(argv[2], workers, maxSessions, hashMB);
+        return daemon.run();
+    }
+
+    // Root-splitting search worker: --worker <socket path | host:port> [hash MB]
+    if (argc > 1 && std::string(argv[1]) == "--worker") {
+        if (argc < 3) {
+            std::cerr << "usage: --worker <socket path | host:port> [hash MB]\n";
+            return 1;
+        }
+        SplitWorker worker(argv[2], argc > 3 ? std::atoi(argv[3]) : 256);
+        return worker.run();
+    }
+
+    // Distributed search over workers:
+    // --coordinate <depth> <worker>[,<worker>...] [startpos [moves ...] | fen <fen> [moves ...]]
+    if (argc > 1 && std::string(argv[1]) == "--coordinate") {
+        if (argc < 4) {
+            std::cerr << "usage: --coordinate <depth> <worker>[,<worker>...] [position]\n";
+            return 1;
+        }
+        std::vector<std::string> workers;
+        std::stringstream list(argv[3]);
+        std::string address;
+        while (std::getline(list, address, ',')) {
+            if (!address.empty()) workers.push_back(address);
+        }
+
+        std::string spec;
+        for (int i = 4; i < argc; i++) spec += std::string(i > 4 ? " " : "") + argv[i];
+
+        Coordinator coordinator(workers, std::atoi(argv[2]));
+        return coordinator.run(spec.empty() ? "startpos" : spec);
+    }
+
+    // Reproducible speed check: --bench [depth] [threads] [--perf]
+    // Positions go to stderr, the totals to stdout; the node count is the signature.
+    // --perf adds hardware counters per node (Linux perf events, when permitted)
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        bool perf = std::string(argv[argc - 1]) == "--perf";
+        int args = perf ? argc - 1 : argc;
+        int depth = args > 2 ? std::atoi(argv[2]) : Bench::DEFAULT_DEPTH;
+        int threads = args > 3 ? std::atoi(argv[3]) : 1;
+
+        std::mutex printMutex;
+        BenchResult result = Bench::run(depth, threads, [&](int index, const std::string& fen, long long nodes) {
+            std::lock_guard<std::mutex> lock(printMutex);
+            std::cerr << "Position " << index + 1 << "/" << Bench::suiteSize() << " (" << fen << "): "
+                      << nodes << " nodes\n";
+        }, perf);
+
+        std::cout << "Depth           : " << result.depth << "\n"
+                  << "Threads         : " << result.threads << "\n"
+                  << "Positions       : " << result.positions << "\n"
+                  << "Total time (ms) : " << result.timeMs << "\n"
+                  << "Nodes searched  : " << result.nodes << "\n"
+                  << "Nodes/second    : " << result.nps << "\n";
+        if (perf) {
+            if (!result.perf.any()) std::cout << "Perf counters   : unavailable\n";
+            for (int i = 0; i < PerfReading::EVENTS; i++) {
+                if (!result.perf.valid[i]) continue;
+                std::string label = std::string(PerfCounters::name(i)) + "/node";
+                label.resize(std::max<size_t>(label.size(), 16), ' ');
+                std::cout << label << ": " << std::fixed << std::setprecision(1)
+                          << (double)result.perf.value[i] / std::max(result.nodes, 1LL) << "\n";
+            }
+        }
+        return 0;
+    }
+
+    // Offline endgame tablebase generation: --gen-tb [dir] [men] [threads]
+    if (argc > 1 && std::string(argv[1]) == "--gen-tb") {
+        std::string dir = argc > 2 ? argv[2] : "tablebases";
+        int men = argc > 3 ? std::atoi(argv[3]) : 4;
+        int threads = argc > 4 ? std::atoi(argv[4]) : (int)std::thread::hardware_concurrency();
+
+        TablebaseGenerator generator(dir, threads);
+        return generator.run(men) ? 0 : 1;
+    }
+
+    // Offline opening book build: --build-book <book.bin> <games.pgn>...
+    if (argc > 1 && std::string(argv[1]) == "--build-book") {
+        if (argc < 4) {
+            std::cerr << "usage: --build-book <book.bin> <games.pgn>...\n";
+            return 1;
+        }
+
+        BookBuilder builder;
+        for (int i = 3; i < argc; i++) {
+            if (!builder.addFile(argv[i])) std::cerr << "cannot read " << argv[i] << "\n";
+        }
+        return builder.write(argv[2]) ? 0 : 1;
     }
 
     if (!api) {
         std::cout << "\nInitializing board..\n\n\n";
     }
 
-    Shell shell(api);
+    Shell shell(api, binary);
     
     return shell.run();
     
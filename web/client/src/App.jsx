@@ -21,6 +21,7 @@ function App() {
   const [bestMoveStr, setBestMoveStr] = useState(null);
   const [topLines, setTopLines] = useState([]); // top 3 engine lines for the player
   const [isAnalyzing, setIsAnalyzing] = useState(false); // true when computing hints
+  const [searchInfo, setSearchInfo] = useState(null); // latest per-depth progress of a running search
   const [moveHistory, setMoveHistory] = useState([]);
   const [gameStatus, setGameStatus] = useState('playing');
   const [statusMessage, setStatusMessage] = useState('');
@@ -189,9 +190,17 @@ function App() {
       return;
     }
 
+    // ── search progress (one line per completed depth) ──
+    if (msg.type === 'info') {
+      setEngineEval(msg.score);
+      setSearchInfo(msg);
+      return;
+    }
+
     // ── search result ──
     if (msg.eval !== undefined) {
       setEngineEval(msg.eval);
+      setSearchInfo(null);
       setIsThinking(false);
       setIsAnalyzing(false);
 
@@ -203,6 +212,10 @@ function App() {
         console.log('[App] Hint received:', msg.topMoves?.length, 'lines');
         setTopLines(msg.topMoves || []);
         setBestMoveStr(msg.bestmove || null);
+        // Let the engine think about its reply to the hinted move while the player decides
+        if (gameModeRef.current === 'engine') {
+          wsSend('ponder ' + ENGINE_DEPTH);
+        }
         return;
       }
 
@@ -586,7 +599,11 @@ function App() {
               {isAnalyzing ? '⏳ Analyzing…' : '💡 Best Lines'}
             </div>
             {isAnalyzing && (
-              <div style={{ color: '#71717a', fontSize: '13px', fontStyle: 'italic', padding: '4px 0' }}>Computing…</div>
+              <div style={{ color: '#71717a', fontSize: '13px', fontStyle: 'italic', padding: '4px 0' }}>
+                {searchInfo
+                  ? `Depth ${searchInfo.depth}/${searchInfo.seldepth} · ${searchInfo.pv.slice(0, 5).join(' ')}`
+                  : 'Computing…'}
+              </div>
             )}
             {!isAnalyzing && topLines.length === 0 && (
               <div style={{ color: '#52525b', fontSize: '13px', fontStyle: 'italic', padding: '4px 0' }}>Waiting for analysis</div>
@@ -3,6 +3,7 @@ const { WebSocketServer } = require('ws');
 const { spawn } = require('child_process');
 const path = require('path');
 const http = require('http');
+const net = require('net');
 
 const app = express();
 const server = http.createServer(app);
@@ -11,10 +12,98 @@ const wss = new WebSocketServer({ server });
 const ENGINE_PATH = path.resolve(__dirname, '../../');
 const ENGINE_BINARY = path.join(ENGINE_PATH, 'ChessEngine');
 
+// With ENGINE_SOCKET set, all clients share one engine daemon
+// (`ChessEngine --daemon <socket>`) instead of a process each
+const ENGINE_SOCKET = process.env.ENGINE_SOCKET;
+
 // Serve static frontend files (production build)
 app.use(express.static(path.join(__dirname, '../client/dist')));
 
+// --- Daemon mode: one socket, one engine session per WebSocket ---
+const sessions = new Map(); // session id -> ws
+let daemon = null;
+let nextSession = 1;
+
+function connectDaemon() {
+    if (daemon) return daemon;
+
+    daemon = net.createConnection(ENGINE_SOCKET);
+    let buffer = '';
+
+    daemon.on('data', (data) => {
+        buffer += data.toString();
+        const lines = buffer.split('\n');
+        buffer = lines.pop() || '';
+
+        for (const line of lines) {
+            if (!line.trim()) continue;
+            let msg;
+            try {
+                msg = JSON.parse(line);
+            } catch (e) {
+                console.warn(`[Daemon] Non-JSON output skipped: ${line}`);
+                continue;
+            }
+            const ws = sessions.get(msg.session);
+            if (!ws) continue;
+            delete msg.session;
+            try {
+                ws.send(JSON.stringify(msg));
+            } catch (_) { /* ws might be closed */ }
+        }
+    });
+
+    const drop = (err) => {
+        if (err) console.error('[Daemon] Connection error:', err.message);
+        daemon = null;
+        for (const ws of sessions.values()) {
+            try {
+                ws.send(JSON.stringify({ status: 'engine_closed', code: null }));
+                ws.close();
+            } catch (_) { /* ws might already be closed */ }
+        }
+        sessions.clear();
+    };
+    daemon.on('error', drop);
+    daemon.on('close', () => { if (daemon) drop(); });
+
+    return daemon;
+}
+
+function attachDaemonSession(ws) {
+    const id = `ws${nextSession++}`;
+    sessions.set(id, ws);
+    console.log(`[WSS] Client connected (session ${id})`);
+
+    ws.on('message', (message) => {
+        const msg = message.toString().trim();
+        if (!msg) return;
+
+        // All sessions share the daemon socket: a line break inside a message would
+        // start a command line of its own, possibly for another client's session
+        if (/[\r\n]/.test(msg)) {
+            console.warn(`[Client ${id}] message with a line break dropped`);
+            ws.send(JSON.stringify({ status: 'error', message: 'Commands must be a single line' }));
+            return;
+        }
+
+        console.log(`[Client ${id} →] ${msg}`);
+        connectDaemon().write(`${id} ${msg}\n`);
+    });
+
+    ws.on('close', () => {
+        console.log(`[WSS] Client disconnected (session ${id})`);
+        sessions.delete(id);
+        if (daemon) daemon.write(`${id} close\n`);
+    });
+}
+
 wss.on('connection', (ws) => {
+    if (ENGINE_SOCKET) {
+        attachDaemonSession(ws);
+        return;
+    }
+
     console.log('[WSS] Client connected');
 
     // Spawn engine instance for this client